@@ -113,9 +113,9 @@ void dump_Boolean(ostream& stream, int padding, Boolean b);
 void Expression_class::dump_type(ostream& stream, int n)
 {
   if (type)
-    { stream << pad(n) << ": " << type << endl; }
+    { stream << pad(n) << ": " << type << "\n"; }
   else
-    { stream << pad(n) << ": _no_type" << endl; }
+    { stream << pad(n) << ": _no_type\n"; }
 }
 
 void dump_line(ostream& stream, int n, tree_node *t)
@@ -24,6 +24,8 @@
 
 extern int yy_flex_debug;       // for the lexer; prints recognized rules
 extern int cool_yydebug;        // for the parser
+       int incremental_parse;   // reuse unchanged classes from the last parse
+       int descent_parse;       // use the recursive-descent parser
        int lex_verbose;         // also for the lexer; prints tokens
        int semant_debug;        // for semantic analysis
        int cgen_debug;          // for code gen
@@ -46,6 +48,8 @@ void handle_flags(int argc, char *argv[]) {
   // no debugging or optimization by default
   yy_flex_debug = 0;
   cool_yydebug = 0;
+  incremental_parse = 0;
+  descent_parse = 0;
   lex_verbose  = 0;
   semant_debug = 0;
   cgen_debug = 0;
@@ -53,7 +57,7 @@ void handle_flags(int argc, char *argv[]) {
   disable_reg_alloc = 0;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lpidscvrOo:gtT")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -96,6 +100,12 @@ void handle_flags(int argc, char *argv[]) {
     case 'o':  // set the name of the output file
       out_filename = optarg;
       break;
+    case 'i':  // reuse unchanged classes from the last parse
+      incremental_parse = 1;
+      break;
+    case 'd':  // parse with the recursive-descent parser instead of cool.y
+      descent_parse = 1;
+      break;
     case 'O':  // enable optimization
       cgen_optimize = 1;
       break;
@@ -111,9 +121,9 @@ void handle_flags(int argc, char *argv[]) {
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvpidscOgtTr -o outname] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-idOgtT -o outname] [input-files]\n";
 #endif
       exit(1);
   }
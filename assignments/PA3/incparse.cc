@@ -0,0 +1,348 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  incparse.cc
+//
+//  Incremental, class-granularity parsing (parser -i).
+//
+//  The token stream is split into one chunk per class: a chunk starts at
+//  a CLASS token and runs up to the next CLASS token or file boundary.
+//  For every chunk we record its byte range in the token stream and its
+//  source line span, and fingerprint its tokens with line numbers taken
+//  relative to the chunk's first line, so a class that merely moved
+//  keeps its fingerprint.
+//
+//  The parsed class__class subtree of every chunk is kept in the cache
+//  directory ($COOL_CACHE_DIR/classes, default .coolcache/classes) under
+//  its fingerprint, serialized exactly as dump_with_types prints it but
+//  with relative line numbers.  On the next run only the chunks whose
+//  fingerprints are not in the cache are handed to the parser; the rest
+//  are reused and shifted to their new position.  The output is
+//  byte-for-byte what a full parse prints.
+//
+//  Anything unusual -- stray tokens outside a class, a chunk that does
+//  not parse as exactly one class -- falls back to a full parse of the
+//  whole stream, so error messages and recovery are those of a plain
+//  parse.
+//
+//  Set COOL_CACHE_STATS to get a one-line summary on stderr.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include "cool-io.h"
+#include "cool-tree.h"
+#include "utilities.h"
+
+extern FILE *token_file;
+extern Program ast_root;
+extern Classes parse_results;
+extern int omerrs;
+extern int cool_yyparse();
+extern int cool_rdparse();
+extern int descent_parse;
+extern void yyrestart(FILE *);
+
+typedef unsigned long long fingerprint;
+
+struct ClassChunk {
+   int begin, end;            // byte range in the token stream
+   int first_line, last_line; // source lines covered by the class
+   std::string name_line;     // "#name" line of the file it came from
+   fingerprint fp;
+};
+
+static const fingerprint FNV_OFFSET = 14695981039346656037ULL;
+static const fingerprint FNV_PRIME  = 1099511628211ULL;
+
+static fingerprint fnv(fingerprint h, const char *s, int len)
+{
+   for (int i = 0; i < len; i++) {
+      h ^= (unsigned char) s[i];
+      h *= FNV_PRIME;
+   }
+   return h;
+}
+
+//
+// The parser binary takes part in every fingerprint, so a rebuilt
+// grammar never picks up subtrees produced by an older one.
+//
+static fingerprint parser_fingerprint()
+{
+   fingerprint h = FNV_OFFSET;
+   FILE *f = fopen("/proc/self/exe", "rb");
+   if (f == NULL) return h;
+   char buf[1 << 16];
+   size_t n;
+   while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      h = fnv(h, buf, n);
+   fclose(f);
+   return h;
+}
+
+//
+// A token line looks like "#<lineno> TOKEN [value]".  Returns the line
+// number and sets *rest to the text after it, or returns -1 for any
+// other line (e.g. "#name").
+//
+static int token_lineno(const char *line, const char **rest)
+{
+   if (line[0] != '#' || line[1] < '0' || line[1] > '9') return -1;
+   const char *p = line + 1;
+   int n = 0;
+   while (*p >= '0' && *p <= '9') n = n * 10 + (*p++ - '0');
+   *rest = p;
+   return n;
+}
+
+static bool starts_with(const char *s, const char *prefix)
+{
+   return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+//
+// Split the token stream into class chunks.  Returns false if the
+// stream contains anything the chunker does not understand.
+//
+static bool split_classes(const std::string& text, std::vector<ClassChunk>& chunks)
+{
+   std::string name_line;
+   ClassChunk *cur = NULL;
+   int pos = 0;
+   int size = text.size();
+
+   while (pos < size) {
+      int eol = text.find('\n', pos);
+      if (eol < 0) eol = size;
+      std::string line = text.substr(pos, eol - pos);
+      const char *rest;
+      int lineno = token_lineno(line.c_str(), &rest);
+
+      if (starts_with(line.c_str(), "#name ")) {
+         if (cur) cur->end = pos;
+         cur = NULL;
+         name_line = line;
+      } else if (lineno >= 0 && strcmp(rest, " CLASS") == 0) {
+         if (cur) cur->end = pos;
+         chunks.push_back(ClassChunk());
+         cur = &chunks.back();
+         cur->begin = pos;
+         cur->first_line = cur->last_line = lineno;
+         cur->name_line = name_line;
+         cur->fp = 0;
+      } else if (lineno >= 0 && cur != NULL) {
+         cur->last_line = lineno;
+      } else if (line.size() != 0) {
+         return false;
+      }
+      pos = eol + 1;
+   }
+   if (cur) cur->end = size;
+   return !chunks.empty();
+}
+
+static fingerprint chunk_fingerprint(const std::string& text, const ClassChunk& c,
+                                     fingerprint seed)
+{
+   fingerprint h = fnv(seed, c.name_line.c_str(), c.name_line.size());
+   int pos = c.begin;
+
+   while (pos < c.end) {
+      int eol = text.find('\n', pos);
+      if (eol < 0 || eol > c.end) eol = c.end;
+      std::string line = text.substr(pos, eol - pos);
+      const char *rest;
+      int lineno = token_lineno(line.c_str(), &rest);
+      char rel[16];
+      int len = sprintf(rel, "\n%d", lineno - c.first_line);
+      h = fnv(h, rel, len);
+      h = fnv(h, rest, strlen(rest));
+      pos = eol + 1;
+   }
+   return h;
+}
+
+//
+// Rewrite the "#<lineno>" marker lines of a dumped subtree by `delta'.
+// Marker lines are the only dump lines that are blank-padded '#'
+// followed by digits: symbols never start with '#' and string
+// constants are quoted.  "#0" is left alone: it is the line of nodes
+// that have none (no_expr), not a position in the source, so cached
+// subtrees are stored with the chunk's first line as 1 rather than 0.
+//
+static std::string shift_lines(const std::string& dump, int delta)
+{
+   std::string out;
+   int pos = 0;
+   int size = dump.size();
+
+   out.reserve(size + 16);
+   while (pos < size) {
+      int eol = dump.find('\n', pos);
+      if (eol < 0) eol = size;
+      int p = pos;
+      while (p < eol && dump[p] == ' ') p++;
+      const char *rest;
+      int lineno = -1;
+      if (p < eol && dump[p] == '#') {
+         std::string marker = dump.substr(p, eol - p);
+         lineno = token_lineno(marker.c_str(), &rest);
+         if (lineno >= 0 && *rest != '\0') lineno = -1;
+      }
+      if (lineno > 0) {
+         char num[16];
+         out.append(dump, pos, p - pos);
+         sprintf(num, "#%d", lineno + delta);
+         out.append(num);
+      } else {
+         out.append(dump, pos, eol - pos);
+      }
+      out.push_back('\n');
+      pos = eol + 1;
+   }
+   return out;
+}
+
+static std::string cache_dir()
+{
+   const char *dir = getenv("COOL_CACHE_DIR");
+   std::string d = dir ? dir : ".coolcache";
+   mkdir(d.c_str(), 0777);
+   d += "/classes";
+   mkdir(d.c_str(), 0777);
+   return d;
+}
+
+static std::string cache_path(const std::string& dir, fingerprint fp)
+{
+   char name[32];
+   sprintf(name, "/%016llx.cls", fp);
+   return dir + name;
+}
+
+static bool read_file(const std::string& path, std::string& contents)
+{
+   FILE *f = fopen(path.c_str(), "rb");
+   if (f == NULL) return false;
+   char buf[1 << 16];
+   size_t n;
+   contents.clear();
+   while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      contents.append(buf, n);
+   fclose(f);
+   return true;
+}
+
+static void write_file(const std::string& path, const std::string& contents)
+{
+   char suffix[32];
+   sprintf(suffix, ".%d.tmp", (int) getpid());
+   std::string tmp = path + suffix;
+   FILE *f = fopen(tmp.c_str(), "wb");
+   if (f == NULL) return;
+   bool ok = fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+   ok = (fclose(f) == 0) && ok;
+   if (ok) rename(tmp.c_str(), path.c_str());
+   else unlink(tmp.c_str());
+}
+
+//
+// Run the parser (cool.y, or rdparse.cc with -d) over `text'.  Parse
+// errors are reported as usual unless `quiet' is set.
+//
+static void parse_text(const std::string& text, bool quiet)
+{
+   std::streambuf *saved = cerr.rdbuf();
+   std::ostringstream discard;
+
+   token_file = fmemopen((void *) text.data(), text.size(), "r");
+   yyrestart(token_file);
+   ast_root = NULL;
+   parse_results = NULL;
+   if (quiet) cerr.rdbuf(discard.rdbuf());
+   if (descent_parse) cool_rdparse();
+   else cool_yyparse();
+   if (quiet) cerr.rdbuf(saved);
+   fclose(token_file);
+}
+
+static int full_parse(const std::string& text, ostream& out)
+{
+   omerrs = 0;
+   parse_text(text, false);
+   if (omerrs != 0) {
+      cerr << "Compilation halted due to lex and parse errors\n";
+      exit(1);
+   }
+   ast_root->dump_with_types(out, 0);
+   return 0;
+}
+
+static double now_ms()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+int parse_incrementally(ostream& out)
+{
+   double start = now_ms();
+   std::string text;
+   char buf[1 << 16];
+   size_t n;
+   while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0)
+      text.append(buf, n);
+
+   std::vector<ClassChunk> chunks;
+   if (!split_classes(text, chunks))
+      return full_parse(text, out);
+
+   std::string dir = cache_dir();
+   fingerprint seed = parser_fingerprint();
+   if (descent_parse) seed = fnv(seed, "-d", 2);
+   std::string program;
+   int reparsed = 0;
+
+   for (size_t i = 0; i < chunks.size(); i++) {
+      ClassChunk& c = chunks[i];
+      c.fp = chunk_fingerprint(text, c, seed);
+      std::string path = cache_path(dir, c.fp);
+      std::string dump;
+
+      if (!read_file(path, dump)) {
+         std::string source = c.name_line + "\n" + text.substr(c.begin, c.end - c.begin);
+         omerrs = 0;
+         parse_text(source, true);
+         if (omerrs != 0 || parse_results == NULL || parse_results->len() != 1)
+            return full_parse(text, out);
+
+         std::ostringstream s;
+         parse_results->nth(0)->dump_with_types(s, 2);
+         // A subtree with a line before its class's would not come back
+         // as it was; it is parsed again next time instead.
+         dump = shift_lines(s.str(), 1 - c.first_line);
+         if (shift_lines(dump, c.first_line - 1) == s.str())
+            write_file(path, dump);
+         reparsed++;
+      }
+      program += shift_lines(dump, c.first_line - 1);
+   }
+
+   // The program node takes the line of its first class.
+   out << "#" << chunks[0].first_line << "\n_program\n" << program;
+
+   if (getenv("COOL_CACHE_STATS"))
+      cerr << "class-cache: " << chunks.size() << " classes, "
+           << reparsed << " reparsed, " << chunks.size() - reparsed << " reused, "
+           << now_ms() - start << " ms\n";
+   return 0;
+}
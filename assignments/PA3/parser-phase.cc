@@ -31,11 +31,20 @@ char *curr_filename = "<stdin>";
 extern int omerrs;             // a count of lex and parse errors
 
 extern int cool_yyparse();
+extern int cool_rdparse();
+extern int parse_incrementally(ostream& out);
+extern int incremental_parse;
+extern int descent_parse;
 void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
     handle_flags(argc, argv);
-    cool_yyparse();
+    if (incremental_parse)
+	return parse_incrementally(cout);
+    if (descent_parse)
+	cool_rdparse();
+    else
+	cool_yyparse();
     if (omerrs != 0) {
 	cerr << "Compilation halted due to lex and parse errors\n";
 	exit(1);
@@ -0,0 +1,553 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  rdparse.cc
+//
+//  Hand-written recursive-descent parser for COOL (parser -d).
+//
+//  cool_rdparse() is a drop-in replacement for cool_yyparse(): it pulls
+//  tokens from cool_yylex(), builds the same cool-tree.h nodes with the
+//  same line numbers, and leaves its result in ast_root / parse_results
+//  and its error count in omerrs.
+//
+//  Expressions are parsed by precedence climbing.  From loosest to
+//  tightest binding:
+//
+//      let, <-        prefix forms; their body extends as far as possible
+//      not            prefix; its operand may contain comparisons
+//      < <= =         non-associative
+//      + -            left-associative
+//      * /            left-associative
+//      isvoid, ~      prefix; their operand is a single postfix expression
+//      @ .            postfix dispatch
+//
+//  Every node takes the line of the token that identifies it: the
+//  operator for unary and binary expressions, the '.' for dispatch, the
+//  identifier for assignments, let bindings, features, formals and case
+//  branches, and the keyword (or '{') for everything else.  no_expr is
+//  always on line 0.
+//
+//  Error recovery mirrors the bison parser token for token.  A syntax
+//  error unwinds to the innermost enclosing recovery point:
+//
+//      class list     skip to ';' and go on with the next class
+//      feature list   skip to ';' and go on with the next feature; this
+//                     also covers the ';' after a class's closing '}'
+//      formals        skip to ')' and go on with the method's return type
+//      block          skip to ';' and go on with the next statement
+//      let            skip to ',' (more bindings follow) or to IN (the
+//                     body follows); this covers the let body as well
+//
+//  Like yacc, no error is reported until three tokens have been shifted
+//  since the last one, and running into end of input while skipping
+//  tokens abandons the parse.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "cool-io.h"
+#include "cool-tree.h"
+#include "cool-parse.h"
+#include "utilities.h"
+
+extern int cool_yylex();
+extern int curr_lineno;
+extern int node_lineno;
+extern char *curr_filename;
+extern Program ast_root;
+extern Classes parse_results;
+extern int omerrs;
+
+static int tok;           // the lookahead token; cool_yylval holds its value
+static int errstatus;     // tokens left to shift before errors are reported
+static Symbol self_sym, object_sym;
+static Symbol filename_sym;    // curr_filename, interned once per file
+
+struct SyntaxError { };   // unwinds to the innermost recovery point
+struct ParseAbort { };    // recovery ran into the end of the input
+
+//
+// Shift the lookahead and read the next token.
+//
+static void advance()
+{
+   if (errstatus > 0) errstatus--;
+   tok = cool_yylex();
+}
+
+static void syntax_error()
+{
+   if (errstatus == 0) {
+      cerr << "\"" << curr_filename << "\", line " << curr_lineno << ": "
+           << "syntax error at or near ";
+      print_cool_token(tok);
+      cerr << endl;
+      omerrs++;
+      if (omerrs > 50) { fprintf(stdout, "More than 50 errors\n"); exit(1); }
+   }
+   errstatus = 3;
+   throw SyntaxError();
+}
+
+static void expect(int t)
+{
+   if (tok != t) syntax_error();
+   advance();
+}
+
+static Symbol expect_symbol(int t)
+{
+   if (tok != t) syntax_error();
+   Symbol s = cool_yylval.symbol;
+   advance();
+   return s;
+}
+
+//
+// Discard tokens up to one of the synchronizing tokens and shift it.
+// Discarded tokens do not count towards errstatus.
+//
+static int recover(int sync1, int sync2 = -1)
+{
+   while (tok != sync1 && tok != sync2) {
+      if (tok == 0) throw ParseAbort();
+      tok = cool_yylex();
+   }
+   int t = tok;
+   advance();
+   return t;
+}
+
+//
+// Lists are built as balanced append trees, so their depth stays
+// logarithmic in their length.
+//
+template <class Elem>
+static list_node<Elem> *make_list(std::vector<Elem>& v, int lo, int hi)
+{
+   if (lo == hi) return list_node<Elem>::nil();
+   if (hi - lo == 1) return list_node<Elem>::single(v[lo]);
+   int mid = lo + (hi - lo) / 2;
+   list_node<Elem> *l1 = make_list(v, lo, mid);
+   list_node<Elem> *l2 = make_list(v, mid, hi);
+   return list_node<Elem>::append(l1, l2);
+}
+
+template <class Elem>
+static list_node<Elem> *make_list(std::vector<Elem>& v)
+{
+   return make_list(v, 0, (int) v.size());
+}
+
+static Expression no_expr_node()
+{
+   node_lineno = 0;
+   return no_expr();
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Expressions
+//
+////////////////////////////////////////////////////////////////////////
+
+enum { PREC_NONE, PREC_CMP, PREC_ADD, PREC_MUL };
+
+static int binary_prec(int t)
+{
+   switch (t) {
+   case '<': case LE: case '=': return PREC_CMP;
+   case '+': case '-':          return PREC_ADD;
+   case '*': case '/':          return PREC_MUL;
+   default:                     return PREC_NONE;
+   }
+}
+
+static Expression parse_expr();
+static Expression parse_binary(int min_prec);
+
+static Expressions parse_args()
+{
+   std::vector<Expression> args;
+   expect('(');
+   if (tok != ')') {
+      args.push_back(parse_expr());
+      while (tok == ',') {
+         advance();
+         args.push_back(parse_expr());
+      }
+   }
+   expect(')');
+   return make_list(args);
+}
+
+static Expression parse_postfix(Expression e)
+{
+   for (;;) {
+      if (tok == '@') {
+         advance();
+         Symbol type = expect_symbol(TYPEID);
+         int line = curr_lineno;
+         expect('.');
+         Symbol name = expect_symbol(OBJECTID);
+         Expressions args = parse_args();
+         node_lineno = line;
+         e = static_dispatch(e, type, name, args);
+      } else if (tok == '.') {
+         int line = curr_lineno;
+         advance();
+         Symbol name = expect_symbol(OBJECTID);
+         Expressions args = parse_args();
+         node_lineno = line;
+         e = dispatch(e, name, args);
+      } else {
+         return e;
+      }
+   }
+}
+
+//
+// let binding [, binding ...] in body, after the LET.  Each binding
+// becomes its own let node.
+//
+static Expression parse_let()
+{
+   int line = curr_lineno;
+   try {
+      Symbol name = expect_symbol(OBJECTID);
+      expect(':');
+      Symbol type = expect_symbol(TYPEID);
+      Expression init;
+      if (tok == ASSIGN) {
+         advance();
+         init = parse_expr();
+      } else {
+         init = no_expr_node();
+      }
+      Expression body;
+      if (tok == ',') {
+         advance();
+         body = parse_let();
+      } else {
+         expect(IN);
+         body = parse_expr();
+      }
+      node_lineno = line;
+      return let(name, type, init, body);
+   } catch (SyntaxError&) {
+      for (;;) {
+         try {
+            if (recover(',', IN) == ',')
+               return parse_let();
+            parse_expr();
+            return no_expr_node();
+         } catch (SyntaxError&) {
+         }
+      }
+   }
+}
+
+static Expression parse_block()
+{
+   int line = curr_lineno;
+   std::vector<Expression> body;
+   expect('{');
+   do {
+      try {
+         Expression e = parse_expr();
+         expect(';');
+         body.push_back(e);
+      } catch (SyntaxError&) {
+         recover(';');
+      }
+   } while (tok != '}');
+   advance();
+   node_lineno = line;
+   return block(make_list(body));
+}
+
+static Expression parse_case()
+{
+   int line = curr_lineno;
+   advance();
+   Expression expr = parse_expr();
+   std::vector<Case> branches;
+   expect(OF);
+   do {
+      int branch_line = curr_lineno;
+      Symbol name = expect_symbol(OBJECTID);
+      expect(':');
+      Symbol type = expect_symbol(TYPEID);
+      expect(DARROW);
+      Expression e = parse_expr();
+      expect(';');
+      node_lineno = branch_line;
+      branches.push_back(branch(name, type, e));
+   } while (tok != ESAC);
+   advance();
+   node_lineno = line;
+   return typcase(expr, make_list(branches));
+}
+
+static Expression parse_primary()
+{
+   int line = curr_lineno;
+   Symbol sym = cool_yylval.symbol;
+   Expression e, e1, e2;
+
+   switch (tok) {
+   case OBJECTID:
+      advance();
+      if (tok == ASSIGN) {
+         advance();
+         e = parse_expr();
+         node_lineno = line;
+         return assign(sym, e);
+      }
+      if (tok == '(') {
+         Expressions args = parse_args();
+         node_lineno = line;
+         return dispatch(object(self_sym), sym, args);
+      }
+      node_lineno = line;
+      return object(sym);
+   case INT_CONST:
+      advance();
+      node_lineno = line;
+      return int_const(sym);
+   case STR_CONST:
+      advance();
+      node_lineno = line;
+      return string_const(sym);
+   case BOOL_CONST: {
+      Boolean b = cool_yylval.boolean;
+      advance();
+      node_lineno = line;
+      return bool_const(b);
+   }
+   case '(':
+      advance();
+      e = parse_expr();
+      expect(')');
+      return e;
+   case IF:
+      advance();
+      e = parse_expr();
+      expect(THEN);
+      e1 = parse_expr();
+      expect(ELSE);
+      e2 = parse_expr();
+      expect(FI);
+      node_lineno = line;
+      return cond(e, e1, e2);
+   case WHILE:
+      advance();
+      e = parse_expr();
+      expect(LOOP);
+      e1 = parse_expr();
+      expect(POOL);
+      node_lineno = line;
+      return loop(e, e1);
+   case '{':
+      return parse_block();
+   case LET:
+      advance();
+      return parse_let();
+   case CASE:
+      return parse_case();
+   case NEW:
+      advance();
+      sym = expect_symbol(TYPEID);
+      node_lineno = line;
+      return new_(sym);
+   default:
+      syntax_error();
+      return NULL;
+   }
+}
+
+static Expression parse_unary()
+{
+   int line = curr_lineno;
+   Expression e;
+
+   switch (tok) {
+   case NOT:
+      advance();
+      e = parse_binary(PREC_CMP);
+      node_lineno = line;
+      return comp(e);
+   case '~':
+      advance();
+      e = parse_unary();
+      node_lineno = line;
+      return neg(e);
+   case ISVOID:
+      advance();
+      e = parse_unary();
+      node_lineno = line;
+      return isvoid(e);
+   default:
+      return parse_postfix(parse_primary());
+   }
+}
+
+static Expression make_binary(int op, Expression e1, Expression e2)
+{
+   switch (op) {
+   case '+': return plus(e1, e2);
+   case '-': return sub(e1, e2);
+   case '*': return mul(e1, e2);
+   case '/': return divide(e1, e2);
+   case '<': return lt(e1, e2);
+   case LE:  return leq(e1, e2);
+   default:  return eq(e1, e2);
+   }
+}
+
+static Expression parse_binary(int min_prec)
+{
+   Expression e = parse_unary();
+
+   for (;;) {
+      int prec = binary_prec(tok);
+      if (prec == PREC_NONE || prec < min_prec) return e;
+      int op = tok;
+      int line = curr_lineno;
+      advance();
+      Expression rhs = parse_binary(prec + 1);
+      node_lineno = line;
+      e = make_binary(op, e, rhs);
+      // comparisons do not associate
+      if (prec == PREC_CMP && binary_prec(tok) == PREC_CMP) syntax_error();
+   }
+}
+
+static Expression parse_expr()
+{
+   return parse_binary(PREC_CMP);
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Classes and features
+//
+////////////////////////////////////////////////////////////////////////
+
+static Formals parse_formals()
+{
+   std::vector<Formal> formals;
+   expect('(');
+   try {
+      if (tok != ')') {
+         for (;;) {
+            int line = curr_lineno;
+            Symbol name = expect_symbol(OBJECTID);
+            expect(':');
+            Symbol type = expect_symbol(TYPEID);
+            node_lineno = line;
+            formals.push_back(formal(name, type));
+            if (tok != ',') break;
+            advance();
+         }
+      }
+      expect(')');
+   } catch (SyntaxError&) {
+      recover(')');
+   }
+   return make_list(formals);
+}
+
+static Feature parse_feature()
+{
+   int line = curr_lineno;
+   Symbol name = expect_symbol(OBJECTID);
+   Symbol type;
+   Expression e;
+
+   if (tok == '(') {
+      Formals formals = parse_formals();
+      expect(':');
+      type = expect_symbol(TYPEID);
+      expect('{');
+      e = parse_expr();
+      expect('}');
+      expect(';');
+      node_lineno = line;
+      return method(name, formals, type, e);
+   }
+   expect(':');
+   type = expect_symbol(TYPEID);
+   if (tok == ASSIGN) {
+      advance();
+      e = parse_expr();
+   } else {
+      e = no_expr_node();
+   }
+   expect(';');
+   node_lineno = line;
+   return attr(name, type, e);
+}
+
+static Class_ parse_class()
+{
+   int line = curr_lineno;
+   expect(CLASS);
+   Symbol name = expect_symbol(TYPEID);
+   Symbol parent = object_sym;
+   if (tok == INHERITS) {
+      advance();
+      parent = expect_symbol(TYPEID);
+   }
+   expect('{');
+
+   std::vector<Feature> features;
+   Symbol filename;
+   for (;;) {
+      try {
+         if (tok == '}') {
+            advance();
+            // the class takes the file name current when its ';' is read
+            if (strcmp(filename_sym->get_string(), curr_filename) != 0)
+               filename_sym = stringtable.add_string(curr_filename);
+            filename = filename_sym;
+            expect(';');
+            break;
+         }
+         features.push_back(parse_feature());
+      } catch (SyntaxError&) {
+         recover(';');
+      }
+   }
+   node_lineno = line;
+   return class_(name, parent, make_list(features), filename);
+}
+
+int cool_rdparse()
+{
+   std::vector<Class_> classes;
+
+   self_sym = idtable.add_string("self");
+   object_sym = idtable.add_string("Object");
+   filename_sym = stringtable.add_string(curr_filename);
+   errstatus = 0;
+   tok = cool_yylex();
+   try {
+      do {
+         try {
+            classes.push_back(parse_class());
+         } catch (SyntaxError&) {
+            recover(';');
+         }
+      } while (tok != 0);
+   } catch (ParseAbort&) {
+      return 1;
+   }
+
+   parse_results = make_list(classes);
+   node_lineno = classes.empty() ? curr_lineno : classes[0]->get_line_number();
+   ast_root = program(parse_results);
+   return 0;
+}
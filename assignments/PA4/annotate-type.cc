@@ -11,22 +11,45 @@
 #include "symtab.h"
 #include "semant.h"
 #include <list>
+#include <sstream>
+#include <thread>
+
+extern int semant_jobs;
+
+//
+// An error that stops compilation.  A thread checking classes in
+// parallel cannot exit for its class; it logs the message and unwinds to
+// check_classes_in_parallel, which exits once the logs of the classes
+// before this one have been printed.
+//
+struct SemantHalt { };
+static thread_local bool checking_in_parallel = false;
+
+static void semant_fatal_error(char *msg)
+{
+   if (!checking_in_parallel) fatal_error(msg);
+   *semant_log << msg;
+   throw SemantHalt();
+}
 
 static inline void scope_enter()
 {
    vartable->enterscope();
+   if (++semant_counters.scope_depth > semant_counters.max_scope_depth)
+      semant_counters.max_scope_depth = semant_counters.scope_depth;
 }
 
 static inline void scope_exits()
 {
    vartable->exitscope();
+   semant_counters.scope_depth--;
 }
 
 static bool is_valid_class(Symbol cs)
 {
    if (classtable == 0) {
       semant_error_log("classtable has not been initialized!\n");
-      fatal_error("Compilation halted due to static semantic errors.\n");
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
    }
 
    if (cs == SELF_TYPE) {
@@ -48,6 +71,7 @@ static bool is_valid_class(Symbol cs)
 
 static bool class_is_comfort(Symbol cs1, Symbol cs2)
 {
+   semant_counters.conformance_checks++;
 
    if (!is_valid_class(cs1) || !is_valid_class(cs2)) {
       return false;
@@ -61,6 +85,12 @@ static bool class_is_comfort(Symbol cs1, Symbol cs2)
       cs2 = cur_class->get_class_name();
    }
 
+   int id1 = classtable->class_id(cs1);
+   int id2 = classtable->class_id(cs2);
+   if (id1 >= 0 && id2 >= 0 && classtable->in_tree(id1) && classtable->in_tree(id2)) {
+      return classtable->is_subclass(id1, id2);
+   }
+
    Class_ c1 = classtable->get_class_by_symbol(cs1);
    Class_ c2 = classtable->get_class_by_symbol(cs2);
    if (cs1 == Object) {
@@ -80,6 +110,7 @@ static bool class_is_comfort(Symbol cs1, Symbol cs2)
 
 Symbol type_join(Symbol cs1, Symbol cs2)
 {
+   semant_counters.type_joins++;
 
    if (!is_valid_class(cs1) || !is_valid_class(cs2)) {
       return Object;
@@ -97,6 +128,13 @@ Symbol type_join(Symbol cs1, Symbol cs2)
       cs2 = cur_class->get_class_name();
    }
 
+   int id1 = classtable->class_id(cs1);
+   int id2 = classtable->class_id(cs2);
+   if (id1 >= 0 && id2 >= 0 && classtable->in_tree(id1) && classtable->in_tree(id2)) {
+      int lca = classtable->least_common_ancestor(id1, id2);
+      return classtable->get_class_by_id(lca)->get_class_name();
+   }
+
    Class_ c1 = classtable->get_class_by_symbol(cs1);
    Class_ c2 = classtable->get_class_by_symbol(cs2);
    std::list<Class_> c1_ancestor_path;
@@ -127,6 +165,18 @@ Symbol type_join(Symbol cs1, Symbol cs2)
    return Object;
 }
 
+//
+// Formals::nth exits when `i' is out of range.  The override checks rely
+// on that; nth_formal exits the same way through semant_fatal_error, so
+// a thread checking in parallel can report it in order.
+//
+static Formal nth_formal(Formals formals, int i)
+{
+   if (i >= formals->len())
+      semant_fatal_error("error: outside the range of the list\n");
+   return formals->nth(i);
+}
+
 static void check_ancestor_method_override(Symbol ancestor, method_class* method)
 {
    Class_ ac = classtable->get_class_by_symbol(ancestor);
@@ -144,10 +194,10 @@ static void check_ancestor_method_override(Symbol ancestor, method_class* method
             semant_error_log(log_buf);
          }
          for(int i = m->formals->first(); m->formals->more(i); i = m->formals->next(i)) {
-            if (m->formals->nth(i)->get_type_decl() != method->formals->nth(i)->get_type_decl()) {
+            if (m->formals->nth(i)->get_type_decl() != nth_formal(method->formals, i)->get_type_decl()) {
                sprintf(log_buf, "In redefined method %s, parameter type %s is different from original type %s.",
                                 method->get_method_name()->get_string(),
-                                method->formals->nth(i)->get_type_decl()->get_string(),
+                                nth_formal(method->formals, i)->get_type_decl()->get_string(),
                                 m->formals->nth(i)->get_type_decl()->get_string());
                semant_error_log(log_buf);
             }
@@ -158,45 +208,143 @@ static void check_ancestor_method_override(Symbol ancestor, method_class* method
    check_ancestor_method_override(ac->get_class_parent(), method);
 }
 
+//
+// check_method_override makes the same checks against the hierarchy's
+// dispatch tables: the slot of the method's name leads straight to the
+// nearest ancestor that defines it, and that ancestor's parent to the
+// next, so ancestors without the method are never looked at.
+//
+static void check_method_override(ClassHierarchy *h, method_class* method)
+{
+   Symbol name = method->get_method_name();
+   int a = (*h)[h->lookup(cur_class->get_class_name())].parent_index;
+   int slot = h->find_slot(a, name);
+
+   while (slot >= 0 && a >= 0 && slot < (*h)[a].method_count) {
+      HierClass& ac = (*h)[h->dispatch(a, slot).cls];
+      for(size_t k = 0; k < ac.methods.size(); k++) {
+         HierFeature& m = ac.methods[k];
+         if (m.name != name) continue;
+         if ((int) m.formals.size() != method->formals->len()) {
+            sprintf(log_buf, "Incompatible number of formal parameters in redefined method %s.", name->get_string());
+            semant_error_log(log_buf);
+         }
+         for(size_t i = 0; i < m.formals.size(); i++) {
+            if (m.formals[i] != nth_formal(method->formals, i)->get_type_decl()) {
+               sprintf(log_buf, "In redefined method %s, parameter type %s is different from original type %s.",
+                                name->get_string(),
+                                nth_formal(method->formals, i)->get_type_decl()->get_string(),
+                                m.formals[i]->get_string());
+               semant_error_log(log_buf);
+            }
+         }
+      }
+      a = ac.parent_index;
+   }
+}
+
+//
+// Cycles and undefined parents among the classes in the table are
+// reported before any class is checked (ClassTable::check_inheritance_graph).
+// Only a second definition of a class name can still have a parent
+// that does not exist; its parent chain is otherwise the table's.
+//
 void inherent_checking()
 {
-   Class_ c1 = cur_class;
-   Class_ c2 = cur_class;
-   bool initial = true;
    if (classtable->get_class_by_symbol(cur_class->get_class_parent()) == NULL) {
       sprintf(log_buf, "can't get %s's parent!\n",
-                        c1->get_class_name()->get_string());
+                        cur_class->get_class_name()->get_string());
       semant_error_log(log_buf);
-      fatal_error("Compilation halted due to static semantic errors.\n");
-   }
-
-   // double pointer checking for cyclic inherits
-   while(c1 != NULL && c2 != NULL) {
-      if (c1 == c2 && c1->get_class_name() != Object && !initial) {
-         sprintf(log_buf, "cyclic for class %s!",
-                           c1->get_class_name()->get_string());
-         semant_error_log(log_buf);
-         fatal_error("Compilation halted due to static semantic errors.\n");
-      }
-      c1 = classtable->get_class_by_symbol(c1->get_class_parent());
-      if (c1 == NULL) {
-         break;
-      }
-      c1 = classtable->get_class_by_symbol(c1->get_class_parent());
-      c2 = classtable->get_class_by_symbol(c2->get_class_parent());
-      initial = false;
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
    }
 
+   // A second definition of a class name is checked, but only the first
+   // one is in the hierarchy.
+   ClassHierarchy *h = classtable->hierarchy();
+   if (classtable->get_class_by_symbol(cur_class->get_class_name()) != cur_class) h = NULL;
    Features features = cur_class->get_class_features();
    for(int i = features->first(); features->more(i); i = features->next(i)) {
       Feature f = features->nth(i);
       method_class *m = dynamic_cast<method_class*>(f);
-      if (m) {
+      if (m && h) {
+         check_method_override(h, m);
+      } else if (m) {
          check_ancestor_method_override(cur_class->get_class_parent(), m);
       }
    }
 }
 
+//
+// Inherited attributes.  Rather than re-adding every ancestor's
+// attributes to vartable for each class, the attributes a class inherits
+// are bound once for the whole program, top-down over the hierarchy: an
+// attribute is bound for the subtree of the class declaring it, so all
+// descendants share one entry, and a class only adds its own attributes
+// when its scope is entered.
+//
+// add_ancestor_features left the attribute of the ancestor nearest
+// Object visible when several ancestors declare one name, and the last
+// of several in one class; a binding is kept only for the first such
+// class down from Object, and the last declaration in it.  Bindings for
+// one name therefore cover disjoint subtrees, listed in tag order.
+//
+struct AttrBinding {
+   int first, last;                 // subtree of the declaring class
+   VarSymbolType *var;
+};
+
+static std::unordered_map<Symbol, std::vector<AttrBinding> > attr_bindings;
+static thread_local int inherited_scope = -1;    // tag of cur_class's parent, -1 if unbound
+static thread_local VarSymbolType *self_var;
+
+static void bind_inherited_attrs(ClassHierarchy *h)
+{
+   for(int c = 0; c < h->size(); c++) {
+      HierClass& hc = (*h)[c];
+      for(size_t k = 0; k < hc.attrs.size(); k++) {
+         HierFeature& a = hc.attrs[k];
+         std::vector<AttrBinding>& v = attr_bindings[a.name];
+         if (!v.empty() && v.back().first <= c && c <= v.back().last) {
+            if (v.back().first == c) v.back().var = new VarSymbolType(a.name, a.type);
+            continue;
+         }
+         AttrBinding b = { c, hc.last, new VarSymbolType(a.name, a.type) };
+         v.push_back(b);
+      }
+   }
+}
+
+static VarSymbolType *lookup_inherited_attr(Symbol name)
+{
+   std::unordered_map<Symbol, std::vector<AttrBinding> >::iterator it = attr_bindings.find(name);
+   if (inherited_scope < 0 || it == attr_bindings.end()) return NULL;
+   std::vector<AttrBinding>& v = it->second;
+   int lo = 0, hi = v.size();
+   while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (v[mid].first <= inherited_scope) lo = mid + 1;
+      else hi = mid;
+   }
+   if (lo == 0 || v[lo - 1].last < inherited_scope) return NULL;
+   return v[lo - 1].var;
+}
+
+//
+// Variable lookup in the order the scopes were once stacked: locals and
+// the class's own attributes, then inherited attributes, then self.
+//
+static VarSymbolType *lookup_var(Symbol name)
+{
+   semant_counters.var_lookups++;
+   semant_counters.scopes_searched += semant_counters.scope_depth;
+   VarSymbolType *v = vartable->lookup(name);
+   if (v == NULL || v == self_var) {
+      VarSymbolType *a = lookup_inherited_attr(name);
+      if (a != NULL) return a;
+   }
+   return v;
+}
+
 static void add_ancestor_features()
 {
    Class_ tmp = classtable->get_class_by_symbol(cur_class->get_class_parent());
@@ -213,14 +361,9 @@ static void add_ancestor_features()
    }
 }
 
-static method_class *get_method_declare(Symbol cs, Symbol method_name, Expressions paras)
+static method_class *find_method_declare(Symbol cs, Symbol method_name, Expressions paras)
 {
    method_class* res;
-   if (classtable == 0) {
-      semant_error_log("classtable has not been initialized!\n");
-      fatal_error("Compilation halted due to static semantic errors.\n");
-   }
-
    Class_ c = classtable->get_class_by_symbol(cs);
 
    if (c == NULL) {
@@ -254,7 +397,7 @@ static method_class *get_method_declare(Symbol cs, Symbol method_name, Expressio
 
    if (c->get_class_name() == Object) return NULL;
 
-   res = get_method_declare(c->get_class_parent(), method_name, paras);
+   res = find_method_declare(c->get_class_parent(), method_name, paras);
 
    if (res == NULL) {
       sprintf(log_buf, "Dispatch to undefined method %s.", method_name->get_string());
@@ -264,28 +407,184 @@ static method_class *get_method_declare(Symbol cs, Symbol method_name, Expressio
    return res;
 }
 
+//
+// get_method_declare finds the method a dispatch on `cs' reaches,
+// checks the actual arguments against it and returns its declared
+// return type, or NULL if `cs' has no such method.  Classes in the
+// hierarchy are resolved through their dispatch tables; the rest by
+// walking up the parents.
+//
+static Symbol get_method_declare(Symbol cs, Symbol method_name, Expressions paras)
+{
+   semant_counters.dispatches++;
+   if (classtable == 0) {
+      semant_error_log("classtable has not been initialized!\n");
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
+   }
+
+   ClassHierarchy *h = classtable->hierarchy();
+   int c = h ? h->lookup(cs) : -1;
+   if (c < 0) {
+      method_class *m = find_method_declare(cs, method_name, paras);
+      return m ? m->get_return_type() : NULL;
+   }
+
+   int slot = h->find_slot(c, method_name);
+   if (slot < 0) {
+      // Deliberately repeated: find_method_declare, which classes
+      // outside the hierarchy still go through, reports the miss once
+      // for every class below Object on the way up, and a dispatch
+      // table must not change what semant prints.
+      for(int i = 0; i < (*h)[c].depth; i++) {
+         sprintf(log_buf, "Dispatch to undefined method %s.", method_name->get_string());
+         semant_error_log(log_buf);
+      }
+      return NULL;
+   }
+
+   HierFeature *m = h->dispatch(c, slot).method;
+   if ((int) m->formals.size() != paras->len()) {
+      sprintf(log_buf, "Method %s called with wrong number of arguments.", method_name->get_string());
+      semant_error_log(log_buf);
+      return m->type;
+   }
+   for(int i = paras->first(); paras->more(i); i = paras->next(i)) {
+      if (!class_is_comfort(paras->nth(i)->type, m->formals[i])) {
+         sprintf(log_buf, "In call of method %s, type %s of parameter y does not conform to declared type %s.",
+                          method_name->get_string(),
+                          paras->nth(i)->type->get_string(),
+                          m->formals[i]->get_string());
+         semant_error_log(log_buf);
+         return m->type;
+      }
+   }
+   return m->type;
+}
+
+//
+// Check `cs' on `jobs' threads.  Each thread takes the next unchecked
+// class, with its own vartable and a log buffer per class; the logs are
+// printed in program order afterwards, so the output is the sequential
+// checker's.  Once a class halts compilation, no class after it is
+// started, and the logs stop after it.
+//
+// What the workers share is only read: classtable, the ClassHierarchy
+// with its dispatch tables, attr_bindings and the string tables.  A
+// worker writes types only into the nodes of the class it took, and
+// its scopes, counters and log go to thread_local state (vartable,
+// cur_class, semant_counters, semant_log, ...).  logs[i] and halted[i]
+// belong to whoever took class i.  The feature and formal lists of
+// every class are indexed up front, so lookups into another class's
+// lists find them already flattened.
+//
+static void flatten_class_lists(std::vector<Class_>& cs)
+{
+   for(size_t i = 0; i < cs.size(); i++) {
+      Features features = cs[i]->get_class_features();
+      for(int j = features->first(); features->more(j); j = features->next(j)) {
+         method_class *m = dynamic_cast<method_class*>(features->nth(j));
+         if (m && m->formals->len() > 0)
+            m->formals->nth(0);
+      }
+   }
+}
+
+static void check_classes_in_parallel(std::vector<Class_>& cs, int jobs)
+{
+   int n = cs.size();
+   flatten_class_lists(cs);
+   std::vector<std::string> logs(n);
+   std::vector<char> halted(n, 0);
+   std::atomic<int> next(0);
+   std::atomic<int> first_halt(n);
+
+   std::vector<std::thread> workers;
+   for(int j = 0; j < jobs; j++) {
+      workers.push_back(std::thread([&]() {
+         checking_in_parallel = true;
+         vartable = new SymbolTable<Symbol, VarSymbolType>();
+         for(int i = next++; i < n && i < first_halt; i = next++) {
+            std::ostringstream log;
+            semant_log = &log;
+            try {
+               ClassCost cost(cs[i]);
+               cs[i]->annotate_with_types();
+            } catch (SemantHalt&) {
+               halted[i] = 1;
+               vartable = new SymbolTable<Symbol, VarSymbolType>();
+               semant_counters.scope_depth = 0;
+               int h = first_halt;
+               while (i < h && !first_halt.compare_exchange_weak(h, i))
+                  ;
+            }
+            logs[i] = log.str();
+         }
+         semant_stats_flush();
+      }));
+   }
+   for(int j = 0; j < jobs; j++)
+      workers[j].join();
+
+   for(int i = 0; i < n; i++) {
+      cerr << logs[i];
+      if (halted[i]) exit(1);
+   }
+}
+
 //
 void program_class::annotate_with_types()
 {
    cur_line = this->get_line_number();
-   for(int i = classes->first(); classes->more(i); i = classes->next(i))
-     classes->nth(i)->annotate_with_types();
+   semant_phase("bind-attrs");
+   if (classtable->hierarchy())
+     bind_inherited_attrs(classtable->hierarchy());
+   semant_phase("check");
+
+   // Classes only share the hierarchy, which is fixed by now, so they
+   // can be checked in any order; a second definition of a class name
+   // still looks at other classes' features and is checked in order.
+   // Classes reused from the previous check (-i) are not checked again.
+   std::vector<Class_> cs;
+   bool independent = classtable->hierarchy() != NULL;
+   for(int i = classes->first(); classes->more(i); i = classes->next(i)) {
+     Class_ c = classes->nth(i);
+     if (classtable->get_class_by_symbol(c->get_class_name()) != c)
+       independent = false;
+     if (!reused_classes.count(c))
+       cs.push_back(c);
+   }
+   if (semant_jobs > 1 && independent) {
+     check_classes_in_parallel(cs, semant_jobs);
+     return;
+   }
+   for(size_t i = 0; i < cs.size(); i++) {
+     ClassCost cost(cs[i]);
+     cs[i]->annotate_with_types();
+   }
 }
 
 void class__class::annotate_with_types()
 {
    cur_line = this->get_line_number();
    scope_enter();
-   vartable->addid(self, new VarSymbolType(self, SELF_TYPE));
+   self_var = new VarSymbolType(self, SELF_TYPE);
+   vartable->addid(self, self_var);
    cur_class = this;
    inherent_checking();
-   add_ancestor_features();
+
+   // A second definition of a class name is not in the hierarchy.
+   ClassHierarchy *h = classtable->hierarchy();
+   inherited_scope = -1;
+   if (h && classtable->get_class_by_symbol(name) == this)
+     inherited_scope = (*h)[h->lookup(name)].parent_index;
+   if (inherited_scope < 0)
+     add_ancestor_features();
    
    for(int i = features->first(); features->more(i); i = features->next(i)) {
       Feature f = features->nth(i);
       attr_class *attr = dynamic_cast<attr_class*>(f);
       if (attr) {
-         if (vartable->lookup(attr->name) != NULL) {
+         if (lookup_var(attr->name) != NULL) {
             sprintf(log_buf, "redef of %s", attr->name->get_string());
             semant_error_log(log_buf);
          }
@@ -361,10 +660,10 @@ void assign_class::annotate_with_types()
    cur_line = this->get_line_number();
    expr->annotate_with_types();
    this->type = expr->type;
-   VarSymbolType *v = vartable->lookup(name);
+   VarSymbolType *v = lookup_var(name);
    if (v == NULL) {
       semant_error_log("variable not declared before use in assign_class\n");
-      fatal_error("Compilation halted due to static semantic errors.\n");
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
    } else {
       if (!class_is_comfort(expr->type, v->type)) {
          sprintf(log_buf, "assign_class is not comfort for expr->type %s and v->type %s", expr->type->get_string(), v->type->get_string());
@@ -384,13 +683,12 @@ void static_dispatch_class::annotate_with_types()
    expr->annotate_with_types();
    for(int i = actual->first(); actual->more(i); i = actual->next(i))
      actual->nth(i)->annotate_with_types();
-   method_class *m = NULL;
-   m = get_method_declare(this->type_name, name, actual);
-   if (m == NULL) {
+   Symbol ret = get_method_declare(this->type_name, name, actual);
+   if (ret == NULL) {
       this->type = Object;
       return;
    }
-   this->type = m->get_return_type();
+   this->type = ret;
 }
 
 //
@@ -405,24 +703,24 @@ void dispatch_class::annotate_with_types()
    for(int i = actual->first(); actual->more(i); i = actual->next(i))
      actual->nth(i)->annotate_with_types();
 
-   method_class *m = NULL;
+   Symbol ret = NULL;
    if (expr->get_type() == SELF_TYPE) {
-      m = get_method_declare(cur_class->get_class_name(), name, actual);
+      ret = get_method_declare(cur_class->get_class_name(), name, actual);
    } else {
-      m = get_method_declare(expr->get_type(), name, actual);
+      ret = get_method_declare(expr->get_type(), name, actual);
    }
    
-   if (m == NULL) {
-      fatal_error("Compilation halted due to static semantic errors.\n");
+   if (ret == NULL) {
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
       this->type = Object;
       return;
    }
-   if (expr->get_type() == SELF_TYPE && m->get_return_type() == SELF_TYPE) {
+   if (expr->get_type() == SELF_TYPE && ret == SELF_TYPE) {
       this->type = SELF_TYPE;
-   } else if (expr->get_type() != SELF_TYPE && m->get_return_type() == SELF_TYPE) {
+   } else if (expr->get_type() != SELF_TYPE && ret == SELF_TYPE) {
       this->type = expr->get_type();
    } else {
-      this->type = m->get_return_type();
+      this->type = ret;
    }
    // this->type = m->get_return_type();
 }
@@ -651,11 +949,11 @@ void no_expr_class::annotate_with_types()
 void object_class::annotate_with_types()
 {
    cur_line = this->get_line_number();
-   VarSymbolType *v = vartable->lookup(name);
+   VarSymbolType *v = lookup_var(name);
    if (v == NULL) {
       sprintf(log_buf, "variable %s not declared before use in object_class", name->get_string());
       semant_error_log(log_buf);
-      fatal_error("Compilation halted due to static semantic errors.\n");
+      semant_fatal_error("Compilation halted due to static semantic errors.\n");
       this->type = Object;
 
    } else {
@@ -47,14 +47,16 @@ typedef Cases_class *Cases;
 #define Program_EXTRAS                          \
 virtual void semant() = 0;			\
 virtual void dump_with_types(ostream&, int) = 0; \
-virtual void annotate_with_types() = 0; 
+virtual void annotate_with_types() = 0; \
+virtual Classes get_classes() = 0;
 
 
 
 #define program_EXTRAS                          \
 void semant();     				\
 void dump_with_types(ostream&, int);     \
-void annotate_with_types();       
+void annotate_with_types();       \
+Classes get_classes() { return classes; }
 
 #define Class__EXTRAS                   \
 virtual Symbol get_filename() = 0;      \
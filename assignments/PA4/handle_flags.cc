@@ -24,12 +24,17 @@
 
 extern int yy_flex_debug;       // for the lexer; prints recognized rules
 extern int cool_yydebug;        // for the parser
+       int emit_hierarchy;      // semant prints the class hierarchy for cgen
        int lex_verbose;         // also for the lexer; prints tokens
        int semant_debug;        // for semantic analysis
+       int semant_stats;        // semant reports counts and timings
+       int semant_jobs;         // threads checking classes in parallel
+       char *previous_ast;      // typed AST of the last check, for semant
        int cgen_debug;          // for code gen
        bool disable_reg_alloc;  // Don't do register allocation
 
        int cgen_optimize;       // optimize switch for code generator 
+       int cgen_bytecode;       // write bytecode for coolvm instead of MIPS
        char *out_filename;      // file name for generated code
        Memmgr cgen_Memmgr = GC_NOGC;      // enable/disable garbage collection
        Memmgr_Test cgen_Memmgr_Test = GC_NORMAL;  // normal/test GC
@@ -46,14 +51,18 @@ void handle_flags(int argc, char *argv[]) {
   // no debugging or optimization by default
   yy_flex_debug = 0;
   cool_yydebug = 0;
+  emit_hierarchy = 0;
   lex_verbose  = 0;
   semant_debug = 0;
+  semant_stats = 0;
+  semant_jobs = 1;
   cgen_debug = 0;
   cgen_optimize = 0;
+  cgen_bytecode = 0;
   disable_reg_alloc = 0;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lphsScvrOo:gtTbj:i:")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -65,6 +74,9 @@ void handle_flags(int argc, char *argv[]) {
     case 's':
       semant_debug = 1;
       break;
+    case 'S':
+      semant_stats = 1;
+      break;
     case 'c':
       cgen_debug = 1;
       break;
@@ -78,6 +90,7 @@ void handle_flags(int argc, char *argv[]) {
     case 'l':
     case 'p':
     case 's':
+    case 'S':
     case 'c': 
     case 'v':
     case 'r':
@@ -99,6 +112,19 @@ void handle_flags(int argc, char *argv[]) {
     case 'O':  // enable optimization
       cgen_optimize = 1;
       break;
+    case 'b':  // lower to bytecode for coolvm
+      cgen_bytecode = 1;
+      break;
+    case 'h':  // hand the class hierarchy from semant to cgen
+      emit_hierarchy = 1;
+      break;
+    case 'j':  // check classes on this many threads
+      semant_jobs = atoi(optarg);
+      if (semant_jobs < 1) unknownopt = 1;
+      break;
+    case 'i':  // re-check only what changed since this typed AST
+      previous_ast = optarg;
+      break;
     case '?':
       unknownopt = 1;
       break;
@@ -111,9 +137,9 @@ void handle_flags(int argc, char *argv[]) {
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvphsScOgtTrb -o outname -j jobs -i previous] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-hOgtTb -o outname -j jobs -i previous] [input-files]\n";
 #endif
       exit(1);
   }
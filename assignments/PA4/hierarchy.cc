@@ -0,0 +1 @@
+../PA5/hierarchy.cc
\ No newline at end of file
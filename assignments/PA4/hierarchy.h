@@ -0,0 +1 @@
+../PA5/hierarchy.h
\ No newline at end of file
@@ -0,0 +1,314 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  incremental.cc
+//
+//  Re-checking only what changed (semant -i previous.ast).
+//
+//  With -i, semant keeps the text of the AST it reads and splits it,
+//  like the typed AST of the previous check, into one block per class.
+//  A class is not checked again, and its previous typed block is
+//  printed in place of a fresh dump, when
+//
+//    - its block is the same as before apart from the type lines, line
+//      numbers included, so a full check would dump it the same way;
+//      and
+//    - every class it depended on has the same interface as before:
+//      parent, attribute names and types, and method names with their
+//      formal and return types.
+//
+//  What a class depended on is read off its previous typed block.
+//  Every type the check resolved is annotated there, next to the
+//  declared types, static dispatch types and allocations, so the
+//  classes named in it, and their ancestors, are all the classes whose
+//  interfaces the check could have looked at: its parents, dispatch
+//  targets and the types of its attributes and formals.  The previous
+//  program passed the check, so a reused class has no errors to report
+//  and the output is that of a full check.
+//
+//  Everything is compared on the dump text, which the parser and semant
+//  print the same way, so the previous typed AST is never parsed back.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include "semant.h"
+
+std::unordered_set<Class_> reused_classes;
+
+static std::string current_text;           // the AST being checked
+static std::string previous_text;          // the -i file
+static std::unordered_map<Class_, std::pair<const char *, const char *> > reused_dumps;
+
+//
+// A class's block of a dump: from its "  #<line>" up to the next one.
+//
+struct ClassText {
+   const char *begin, *end;
+   std::string name, parent;
+   bool same;                      // untyped text unchanged (current side)
+};
+
+typedef std::unordered_map<std::string, ClassText *> ClassTexts;
+
+static const char *next_line(const char *p, const char *end)
+{
+   const char *nl = (const char *) memchr(p, '\n', end - p);
+   return nl ? nl + 1 : end;
+}
+
+static int indent_of(const char *p, const char *end)
+{
+   const char *q = p;
+   while (q < end && *q == ' ') q++;
+   return q - p;
+}
+
+static std::string text_of(const char *p, const char *end)
+{
+   p += indent_of(p, end);
+   const char *q = p;
+   while (q < end && *q != '\n') q++;
+   return std::string(p, q);
+}
+
+static bool is_class_start(const char *p, const char *end)
+{
+   return end - p > 3 && p[0] == ' ' && p[1] == ' ' && p[2] == '#';
+}
+
+static bool is_type_line(const char *p, const char *end)
+{
+   p += indent_of(p, end);
+   return end - p >= 2 && p[0] == ':' && p[1] == ' ';
+}
+
+//
+// Split a program dump into class blocks, skipping a hierarchy printed
+// ahead of it by -h.  Returns false if it is not a program dump.
+//
+static bool split_classes(const std::string& text, std::vector<ClassText>& out)
+{
+   const char *p = text.data(), *end = p + text.size();
+   while (p < end && *p == '%') p = next_line(p, end);
+   p = next_line(p, end);
+   if (text_of(p, end) != "_program") return false;
+   p = next_line(p, end);
+
+   while (p < end) {
+      if (!is_class_start(p, end)) return false;
+      ClassText c;
+      c.begin = p;
+      c.same = false;
+      const char *q = next_line(p, end);
+      if (text_of(q, end) != "_class") return false;
+      q = next_line(q, end);
+      c.name = text_of(q, end);
+      q = next_line(q, end);
+      c.parent = text_of(q, end);
+      while (q < end && !is_class_start(q, end)) q = next_line(q, end);
+      c.end = p = q;
+      out.push_back(c);
+   }
+   return true;
+}
+
+//
+// Whether two blocks are the same once their type lines are dropped.
+//
+static bool same_untyped(const ClassText& a, const ClassText& b)
+{
+   const char *p = a.begin, *q = b.begin;
+   for (;;) {
+      while (p < a.end && is_type_line(p, a.end)) p = next_line(p, a.end);
+      while (q < b.end && is_type_line(q, b.end)) q = next_line(q, b.end);
+      if (p == a.end || q == b.end) return p == a.end && q == b.end;
+      const char *pe = next_line(p, a.end), *qe = next_line(q, b.end);
+      if (pe - p != qe - q || memcmp(p, q, pe - p) != 0) return false;
+      p = pe;
+      q = qe;
+   }
+}
+
+//
+// The interface of a class read off its block.  Features are at indent
+// 4, their name, formals, types and body at 6, a formal's name and type
+// at 8.
+//
+static std::string interface_of(const ClassText& c)
+{
+   std::vector<std::pair<int, std::string> > lines;
+   for(const char *p = c.begin; p < c.end; p = next_line(p, c.end))
+      if (!is_type_line(p, c.end))
+         lines.push_back(std::make_pair(indent_of(p, c.end), text_of(p, c.end)));
+
+   std::string s = c.parent;
+   int n = lines.size();
+   for(int i = 0; i < n; i++) {
+      if (lines[i].first != 4) continue;
+      bool method = lines[i].second == "_method";
+      if (!method && lines[i].second != "_attr") continue;
+
+      std::vector<int> parts;                  // the feature's lines at indent 6
+      for(int k = i + 1; k < n && lines[k].first >= 6; k++)
+         if (lines[k].first == 6) parts.push_back(k);
+      if (parts.size() < 2) continue;
+
+      s += method ? " | m " : " | a ";
+      s += lines[parts[0]].second;
+      size_t k = 1;
+      while (method && k + 1 < parts.size() && lines[parts[k + 1]].second == "_formal") {
+         int f = parts[k + 1];
+         if (f + 2 < n) s += " " + lines[f + 2].second;
+         k += 2;
+      }
+      s += " " + lines[parts[k]].second;
+   }
+   return s;
+}
+
+//
+// Whether a class of the previous program, and every ancestor it had,
+// is still there with the same interface.  Memoized per class name.
+//
+class InterfaceCheck {
+private:
+   ClassTexts& previous;
+   ClassTexts& current;
+   std::unordered_map<std::string, int> state;     // 0 busy, 1 same, 2 changed
+public:
+   InterfaceCheck(ClassTexts& p, ClassTexts& c) : previous(p), current(c) { }
+
+   bool unchanged(const std::string& name)
+   {
+      std::unordered_map<std::string, int>::iterator it = state.find(name);
+      if (it != state.end()) return it->second == 1;
+
+      ClassTexts::iterator p = previous.find(name);
+      if (p == previous.end()) {                    // a basic class
+         state[name] = 1;
+         return true;
+      }
+      ClassTexts::iterator c = current.find(name);
+      state[name] = 0;                              // a cycle reads as changed
+      bool same = c != current.end()
+         && (c->second->same || interface_of(*p->second) == interface_of(*c->second))
+         && unchanged(p->second->parent);
+      state[name] = same ? 1 : 2;
+      return same;
+   }
+};
+
+//
+// Every word of the typed block that names a class of the previous
+// program is a dependency.  Class names start in upper case and object
+// identifiers do not, so only a class name inside a string constant can
+// add one needlessly.
+//
+static bool dependencies_unchanged(const ClassText& c, InterfaceCheck& check)
+{
+   std::string w;
+   for(const char *p = c.begin; p < c.end; ) {
+      const char *q = p;
+      while (q < c.end && *q != ' ' && *q != '\n') q++;
+      if (q > p && isupper((unsigned char) *p)) {
+         w.assign(p, q);
+         if (!check.unchanged(w)) return false;
+      }
+      p = q + 1;
+   }
+   return true;
+}
+
+static void read_all(FILE *f, std::string& text)
+{
+   char buf[1 << 16];
+   size_t n;
+   while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+      text.append(buf, n);
+}
+
+//
+// Read the AST to be checked into memory, keeping its text, and return
+// a stream the AST parser can read it from.
+//
+FILE *keep_current_ast(FILE *f)
+{
+   read_all(f, current_text);
+   FILE *mem = fmemopen((void *) current_text.data(), current_text.size(), "r");
+   if (mem == NULL) {
+      cerr << "semant: cannot buffer the AST" << endl;
+      exit(1);
+   }
+   return mem;
+}
+
+//
+// Mark the classes of `program' whose previous check still holds.  If a
+// dump does not split into the program's classes, nothing is reused.
+//
+void reuse_previous_checks(Program program, char *previous_file)
+{
+   FILE *f = fopen(previous_file, "r");
+   if (f == NULL) {
+      cerr << "semant: cannot open " << previous_file << endl;
+      exit(1);
+   }
+   read_all(f, previous_text);
+   fclose(f);
+
+   std::vector<ClassText> previous, current;
+   Classes classes = program->get_classes();
+   if (!split_classes(previous_text, previous) || !split_classes(current_text, current)
+       || (int) current.size() != classes->len())
+      return;
+
+   ClassTexts previous_by_name, current_by_name;
+   for(size_t i = 0; i < previous.size(); i++)
+      previous_by_name[previous[i].name] = &previous[i];
+   for(size_t i = 0; i < current.size(); i++) {
+      if (current[i].name != classes->nth(i)->get_class_name()->get_string())
+         return;
+      current_by_name[current[i].name] = &current[i];
+   }
+
+   for(size_t i = 0; i < current.size(); i++) {
+      ClassTexts::iterator p = previous_by_name.find(current[i].name);
+      current[i].same = p != previous_by_name.end() && same_untyped(*p->second, current[i]);
+   }
+
+   // An unchanged block declares the same interface, so interfaces are
+   // only read off the blocks that changed.
+   InterfaceCheck check(previous_by_name, current_by_name);
+   for(size_t i = 0; i < current.size(); i++) {
+      if (current[i].same && dependencies_unchanged(*previous_by_name[current[i].name], check)) {
+         ClassText& old = *previous_by_name[current[i].name];
+         Class_ c = classes->nth(i);
+         reused_classes.insert(c);
+         reused_dumps[c] = std::make_pair(old.begin, old.end);
+      }
+   }
+}
+
+//
+// program_class::dump_with_types, with the previous block of every
+// reused class.
+//
+void dump_with_reuse(Program program, ostream& stream)
+{
+   Classes classes = program->get_classes();
+   stream << "#" << program->get_line_number() << "\n";
+   stream << "_program\n";
+   for(int i = classes->first(); classes->more(i); i = classes->next(i)) {
+      std::unordered_map<Class_, std::pair<const char *, const char *> >::iterator it =
+         reused_dumps.find(classes->nth(i));
+      if (it != reused_dumps.end())
+         stream.write(it->second.first, it->second.second - it->second.first);
+      else
+         classes->nth(i)->dump_with_types(stream, 2);
+   }
+}
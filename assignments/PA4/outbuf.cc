@@ -0,0 +1 @@
+../PA5/outbuf.cc
\ No newline at end of file
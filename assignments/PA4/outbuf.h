@@ -0,0 +1 @@
+../PA5/outbuf.h
\ No newline at end of file
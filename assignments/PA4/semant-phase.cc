@@ -1,10 +1,14 @@
 #include <stdio.h>
 #include "cool-tree.h"
+#include "outbuf.h"
+#include "semant.h"
 
 extern Program ast_root;      // root of the abstract syntax tree
 FILE *ast_file = stdin;       // we read the AST from standard input
 extern int ast_yyparse(void); // entry point to the AST parser
 
+extern int emit_hierarchy;    // -h: print the class hierarchy ahead of the AST
+extern char *previous_ast;    // -i: typed AST of the last check, to reuse
 int cool_yydebug;     // not used, but needed to link with handle_flags
 char *curr_filename;
 
@@ -14,8 +18,25 @@ int hang = 0;
 int main(int argc, char *argv[]) {
   while(hang);
   handle_flags(argc,argv);
+  semant_phase("parse");
+  if (previous_ast) ast_file = keep_current_ast(ast_file);
   ast_yyparse();
+  if (previous_ast) {
+    semant_phase("reuse");
+    reuse_previous_checks(ast_root, previous_ast);
+  }
   ast_root->semant();
-  ast_root->dump_with_types(cout,0);
+
+  semant_phase("dump");
+  OutBuf buf(1);
+  ostream out(&buf);
+  if (emit_hierarchy) {
+    ClassHierarchy *h = classtable->hierarchy();
+    if (h != NULL) h->dump(out);
+  }
+  if (previous_ast)
+    dump_with_reuse(ast_root, out);
+  else
+    ast_root->dump_with_types(out,0);
 }
 
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <algorithm>
 #include "semant.h"
 #include "utilities.h"
 
@@ -10,9 +11,10 @@
 extern int semant_debug;
 extern char *curr_filename;
 
-char log_buf[256];
-class__class *cur_class;
-int cur_line = 1;
+thread_local char log_buf[256];
+thread_local class__class *cur_class;
+thread_local int cur_line = 1;
+thread_local ostream *semant_log = &cerr;
 
 Symbol 
     arg,
@@ -78,41 +80,178 @@ static void initialize_constants(void)
 }
 
 
+//
+// Classes are numbered densely in the order they are installed: the
+// basic classes first, then the program's in declaration order.  The
+// number is a class's id; class_ids maps a name to it.
+//
 ClassTable::ClassTable(Classes classes) : semant_errors(0) , error_stream(cerr)
 {
     /* Fill this in */
     install_basic_classes();
+    basic_classes = classlist.size();
     for(int i = classes->first(); classes->more(i); i = classes->next(i)) {
         add_class_to_classlist(classes->nth(i));
     }
+    number_inheritance_tree();
+    check_inheritance_graph();
+    semant_phase("hierarchy");
+    class_tree = build_hierarchy();
     semant_errors = 0;
 }
 
+//
+// Number the classes in depth-first pre- and postorder from Object, so
+// that A conforms to B exactly when A's interval lies inside B's.
+// Classes whose parent chain is broken or cyclic are not reached and
+// keep -1; check_inheritance_graph reports them.
+//
+// The same walk fills the binary-lifting table for least upper bounds:
+// jump[0] is the parent (Object is its own), jump[k] the ancestor 2^k
+// levels up; and records the preorder itself in `order', a topological
+// order of the classes (parents first) for later passes.
+//
+void ClassTable::number_inheritance_tree()
+{
+    int n = classlist.size();
+    std::vector<int> parent(n, -1);
+    std::vector<std::vector<int> > children(n);
+    for(int id = 0; id < n; id++) {
+        int p = class_id(classlist[id]->get_class_parent());
+        if (p >= 0 && p != id) {
+            parent[id] = p;
+            children[p].push_back(id);
+        }
+    }
+
+    preorder.assign(n, -1);
+    postorder.assign(n, -1);
+    order.clear();
+    jump.assign(1, std::vector<int>(n, -1));
+    int root = class_id(Object);
+    if (root < 0) return;
+
+    int pre = 0, post = 0, depth = 0, max_depth = 0;
+    std::vector<std::pair<int, size_t> > stack;   // class, next child
+    preorder[root] = pre++;
+    order.push_back(root);
+    jump[0][root] = root;
+    stack.push_back(std::make_pair(root, 0));
+    while (!stack.empty()) {
+        int c = stack.back().first;
+        size_t k = stack.back().second;
+        if (k < children[c].size()) {
+            stack.back().second++;
+            int child = children[c][k];
+            preorder[child] = pre++;
+            order.push_back(child);
+            jump[0][child] = c;
+            stack.push_back(std::make_pair(child, 0));
+            if (++depth > max_depth) max_depth = depth;
+        } else {
+            postorder[c] = post++;
+            stack.pop_back();
+            depth--;
+        }
+    }
+
+    for(int k = 1; (1 << (k - 1)) < max_depth; k++) {
+        jump.push_back(std::vector<int>(n, -1));
+        for(int id = 0; id < n; id++)
+            if (preorder[id] >= 0)
+                jump[k][id] = jump[k - 1][jump[k - 1][id]];
+    }
+}
+
+//
+// Report every class that number_inheritance_tree could not reach from
+// Object, in one pass: each inheritance cycle once, at its first class
+// in the program, and each class whose parent is not defined.  Classes
+// that merely inherit from such a class are not reported again.  Every
+// unreached class is walked up its parents at most once.
+//
+void ClassTable::check_inheritance_graph()
+{
+    int n = classlist.size();
+    std::vector<char> state(n, 0);                // 0 new, 1 on path, 2 done
+    std::vector<std::pair<int, const char *> > reports;
+    std::vector<int> path;
+
+    for(int id = 0; id < n; id++) {
+        if (in_tree(id) || state[id] != 0) continue;
+        int c = id;
+        while (c >= 0 && state[c] == 0) {
+            state[c] = 1;
+            path.push_back(c);
+            int p = class_id(classlist[c]->get_class_parent());
+            if (p < 0) reports.push_back(std::make_pair(c, "can't get %s's parent!\n"));
+            c = p;
+        }
+        if (c >= 0 && state[c] == 1) {
+            int first = c;
+            for(size_t k = path.size(); path[--k] != c; )
+                if (path[k] < first) first = path[k];
+            reports.push_back(std::make_pair(first, "cyclic for class %s!"));
+        }
+        for(size_t k = 0; k < path.size(); k++) state[path[k]] = 2;
+        path.clear();
+    }
+    if (reports.empty()) return;
+
+    std::sort(reports.begin(), reports.end());
+    for(size_t k = 0; k < reports.size(); k++) {
+        Class_ c = classlist[reports[k].first];
+        cur_class = dynamic_cast<class__class *>(c);
+        cur_line = c->get_line_number();
+        sprintf(log_buf, reports[k].second, c->get_class_name()->get_string());
+        semant_error_log(log_buf);
+    }
+    fatal_error("Compilation halted due to static semantic errors.\n");
+}
+
+//
+// The least common ancestor of two classes in the tree: climb from id1
+// in decreasing powers of two as long as the class reached is not yet
+// an ancestor of id2.
+//
+int ClassTable::least_common_ancestor(int id1, int id2)
+{
+    if (is_subclass(id2, id1)) return id1;
+    if (is_subclass(id1, id2)) return id2;
+    for(int k = jump.size() - 1; k >= 0; k--) {
+        int up = jump[k][id1];
+        if (!is_subclass(id2, up)) id1 = up;
+    }
+    return jump[0][id1];
+}
+
 bool ClassTable::add_class_to_classlist(Class_ c)
 {
     if (c == NULL) {
         return false;
     }
-    if (classlist == NULL) {
-        classlist = list_node<Class_>::single(c);
-        return true;
-    }
-    
-    for(int i = classlist->first(); classlist->more(i); i = classlist->next(i)) {
-        if (classlist->nth(i)->get_class_name() == c->get_class_name()) {
-            sprintf(log_buf, "redefination of class %s", c->get_class_name()->get_string());
-            semant_error_log(log_buf);
-            return false;
-        }
+
+    if (class_ids.count(c->get_class_name())) {
+        sprintf(log_buf, "redefination of class %s", c->get_class_name()->get_string());
+        semant_error_log(log_buf);
+        return false;
     }
-    classlist = classlist->append(classlist, list_node<Class_>::single(c));
+    class_ids[c->get_class_name()] = classlist.size();
+    classlist.push_back(c);
     return true;
 }
 
+int ClassTable::class_id(Symbol s)
+{
+    std::unordered_map<Symbol, int>::iterator it = class_ids.find(s);
+    return it == class_ids.end() ? -1 : it->second;
+}
+
 Class_ ClassTable::get_class_by_symbol(Symbol s)
 {
     /* Fill this in */
-    if (classlist == NULL) {
+    semant_counters.class_lookups++;
+    if (classlist.empty()) {
         fatal_error("classtable has not been initialized!\n");
         return NULL;
     }
@@ -121,13 +260,8 @@ Class_ ClassTable::get_class_by_symbol(Symbol s)
         return NULL;
     }
 
-    for(int i = classlist->first(); classlist->more(i); i = classlist->next(i)) {
-        if (classlist->nth(i)->get_class_name() == s) {
-            return classlist->nth(i);
-        }
-    }
-
-    return NULL;
+    int id = class_id(s);
+    return id < 0 ? NULL : classlist[id];
 }
 
 void ClassTable::install_basic_classes() {
@@ -231,6 +365,40 @@ void ClassTable::install_basic_classes() {
     add_class_to_classlist(Str_class);
 }
 
+//
+// The hierarchy of the program, for method resolution here and for the
+// code generator.  Classes are added parents first, in the order of
+// number_inheritance_tree; basic classes come first in the class list,
+// so they keep the lowest tags among their siblings.
+//
+ClassHierarchy *ClassTable::build_hierarchy()
+{
+    ClassHierarchy *h = new ClassHierarchy;
+
+    for(size_t i = 0; i < order.size(); i++) {
+        int id = order[i];
+        Class_ c = classlist[id];
+        int hc = h->add_class(c->get_class_name(), c->get_class_parent(), id < basic_classes);
+        Features fs = c->get_class_features();
+        for(int j = fs->first(); fs->more(j); j = fs->next(j)) {
+            Feature f = fs->nth(j);
+            if (attr_class *a = dynamic_cast<attr_class *>(f)) {
+                h->add_attr(hc, a->name, a->type_decl);
+            } else if (method_class *m = dynamic_cast<method_class *>(f)) {
+                std::vector<Symbol> formals;
+                for(int k = m->formals->first(); m->formals->more(k); k = m->formals->next(k))
+                    formals.push_back(m->formals->nth(k)->get_type_decl());
+                h->add_method(hc, m->get_method_name(), m->get_return_type(), formals);
+            }
+        }
+    }
+    if (!h->build()) {
+        delete h;
+        return NULL;
+    }
+    return h;
+}
+
 ////////////////////////////////////////////////////////////////////
 //
 // semant_error is an overloaded function for reporting errors
@@ -278,7 +446,7 @@ ostream& ClassTable::semant_error()
      errors. Part 2) can be done in a second stage, when you want
      to build mycoolc.
  */
-SymbolTable<Symbol, VarSymbolType> *vartable;
+thread_local SymbolTable<Symbol, VarSymbolType> *vartable;
 ClassTable *classtable;
 
 void program_class::semant()
@@ -286,6 +454,7 @@ void program_class::semant()
     initialize_constants();
 
     /* ClassTable constructor may do some semantic analysis */
+    semant_phase("classtable");
     classtable = new ClassTable(classes);
 
     /* some semantic analysis code may go here */
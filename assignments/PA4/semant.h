@@ -3,10 +3,16 @@
 
 #include <assert.h>
 #include <iostream>  
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <chrono>
 #include "cool-tree.h"
 #include "stringtab.h"
 #include "symtab.h"
 #include "list.h"
+#include "hierarchy.h"
 
 #define TRUE 1
 #define FALSE 0
@@ -21,16 +27,37 @@ typedef ClassTable *ClassTableP;
 
 class ClassTable {
 private:
-  int semant_errors;
+  std::atomic<int> semant_errors;
   void install_basic_classes();
   ostream& error_stream;
-  Classes classlist;
+  std::vector<Class_> classlist;              // indexed by class id
+  std::unordered_map<Symbol, int> class_ids;  // class name -> class id
+  int basic_classes;
+  std::vector<int> preorder, postorder;       // by class id, -1 if unreached
+  std::vector<std::vector<int> > jump;        // jump[k][id]: 2^k-th ancestor
+  std::vector<int> order;                     // class ids, parents first
+  ClassHierarchy *class_tree;                 // NULL if the classes are no tree
+  void number_inheritance_tree();
+  void check_inheritance_graph();
+  ClassHierarchy *build_hierarchy();
 
 public:
   ClassTable(Classes);
   Class_ get_class_by_symbol(Symbol s);
+  int class_id(Symbol s);
+  Class_ get_class_by_id(int id) { return classlist[id]; }
+  int class_count() { return classlist.size(); }
+
+  // Subclass tests by DFS interval containment.  Only classes that
+  // reach Object through known parents are numbered; in_tree() tells.
+  bool in_tree(int id) { return preorder[id] >= 0; }
+  bool is_subclass(int id, int ancestor) {
+    return preorder[ancestor] <= preorder[id] && postorder[id] <= postorder[ancestor];
+  }
+  int least_common_ancestor(int id1, int id2);
   int errors() { return semant_errors; }
   bool add_class_to_classlist(Class_ c);
+  ClassHierarchy *hierarchy() { return class_tree; }
   ostream& semant_error();
   ostream& semant_error(Class_ c);
   ostream& semant_error(Symbol filename, tree_node *t);
@@ -56,7 +83,7 @@ class FuncSymbolType {
 };
 
 
-extern SymbolTable<Symbol, VarSymbolType> *vartable;
+extern thread_local SymbolTable<Symbol, VarSymbolType> *vartable;
 extern ClassTable *classtable;
 //////////////////////////////////////////////////////////////////////
 //
@@ -95,14 +122,61 @@ extern Symbol
     type_name,
     val;
 
-extern char log_buf[256];
-extern class__class *cur_class;
-extern int cur_line;
-extern ClassTable *classtable;
+//
+// The state of checking one class.  Each thread checking classes has
+// its own; semant_log is cerr unless classes are checked in parallel
+// (-j), when every class logs to a buffer of its own.
+//
+extern thread_local char log_buf[256];
+extern thread_local class__class *cur_class;
+extern thread_local int cur_line;
+extern thread_local ostream *semant_log;
+
+// Classes whose previous check still holds (-i); see incremental.cc.
+extern std::unordered_set<Class_> reused_classes;
+FILE *keep_current_ast(FILE *f);
+void reuse_previous_checks(Program program, char *previous_file);
+void dump_with_reuse(Program program, ostream& stream);
+
+//
+// What checking costs (-S); see stats.cc.  Every thread counts in its
+// own semant_counters.
+//
+struct SemantCounters {
+  long class_lookups;         // ClassTable::get_class_by_symbol
+  long conformance_checks;
+  long type_joins;
+  long var_lookups;
+  long scopes_searched;       // scope depth summed over var_lookups
+  long dispatches;            // methods resolved for a dispatch
+  int scope_depth;
+  int max_scope_depth;
+
+  SemantCounters() : class_lookups(0), conformance_checks(0), type_joins(0),
+    var_lookups(0), scopes_searched(0), dispatches(0), scope_depth(0),
+    max_scope_depth(0) { }
+  void add(const SemantCounters& c);
+};
+
+extern thread_local SemantCounters semant_counters;
+
+void semant_phase(const char *name);
+void semant_stats_flush();
+
+// Times checking a class and records the counts it accounts for.
+class ClassCost {
+private:
+  Class_ cls;
+  SemantCounters start_counts;
+  std::chrono::steady_clock::time_point start;
+public:
+  ClassCost(Class_ c);
+  ~ClassCost();
+};
 
 inline void semant_error_log(char *msg)
 {
-   cerr << "[semant error " << cur_class->get_filename()->get_string() << ":" << cur_line << "] " << msg << endl;
+   *semant_log << "[semant error " << cur_class->get_filename()->get_string() << ":" << cur_line << "] " << msg << endl;
    if (classtable != NULL) {
       classtable->semant_error();
    }
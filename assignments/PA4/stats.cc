@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  stats.cc
+//
+//  Counters and timers for semant -S.
+//
+//  The checker counts class lookups, conformance checks, joins,
+//  variable lookups (with the scope depth they search) and method
+//  resolutions in semant_counters as it goes; each thread counts on its
+//  own and adds its counts to the totals when it is done.  Counting is
+//  always on, it costs an increment; -S only decides whether anything
+//  is reported.
+//
+//  With -S, the wall time of every phase and of every class checked,
+//  with the counts that class accounts for, is printed on stderr when
+//  semant exits, one record per line:
+//
+//      semant-stats: phase <name> <seconds>
+//      semant-stats: class <name> <seconds> <counter>=<n> ...
+//      semant-stats: total <seconds> <counter>=<n> ...
+//
+//  Classes are listed in the order they finished, which with -j is not
+//  program order.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include "semant.h"
+
+extern int semant_stats;
+
+thread_local SemantCounters semant_counters;
+
+typedef std::chrono::steady_clock Clock;
+
+struct ClassRecord {
+   std::string name;
+   double seconds;
+   SemantCounters counts;
+};
+
+static std::mutex stats_lock;
+static SemantCounters totals;
+static std::vector<ClassRecord> class_records;
+static std::vector<std::pair<const char *, double> > phases;
+static const char *phase_name;
+static Clock::time_point phase_start, run_start;
+
+static double seconds_since(Clock::time_point t)
+{
+   return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+void SemantCounters::add(const SemantCounters& c)
+{
+   class_lookups += c.class_lookups;
+   conformance_checks += c.conformance_checks;
+   type_joins += c.type_joins;
+   var_lookups += c.var_lookups;
+   scopes_searched += c.scopes_searched;
+   dispatches += c.dispatches;
+   if (c.max_scope_depth > max_scope_depth) max_scope_depth = c.max_scope_depth;
+}
+
+static void print_counts(const SemantCounters& c)
+{
+   cerr << " class_lookups=" << c.class_lookups
+        << " conformance_checks=" << c.conformance_checks
+        << " type_joins=" << c.type_joins
+        << " var_lookups=" << c.var_lookups
+        << " scopes_searched=" << c.scopes_searched
+        << " max_scope_depth=" << c.max_scope_depth
+        << " dispatches=" << c.dispatches << "\n";
+}
+
+static void report_stats()
+{
+   semant_phase(NULL);
+   semant_stats_flush();
+   cerr << std::fixed << std::setprecision(6);
+   for(size_t i = 0; i < phases.size(); i++)
+      cerr << "semant-stats: phase " << phases[i].first << " " << phases[i].second << "\n";
+   for(size_t i = 0; i < class_records.size(); i++) {
+      cerr << "semant-stats: class " << class_records[i].name << " " << class_records[i].seconds;
+      print_counts(class_records[i].counts);
+   }
+   cerr << "semant-stats: total " << seconds_since(run_start);
+   print_counts(totals);
+}
+
+//
+// End the phase under way, if any, and start `name' (NULL for none).
+// The first call also arranges for the report to be printed at exit,
+// which a halted check reaches too.
+//
+void semant_phase(const char *name)
+{
+   if (!semant_stats) return;
+   Clock::time_point now = Clock::now();
+   if (phase_name != NULL)
+      phases.push_back(std::make_pair(phase_name, std::chrono::duration<double>(now - phase_start).count()));
+   else if (phases.empty() && name != NULL) {
+      run_start = now;
+      atexit(report_stats);
+   }
+   phase_name = name;
+   phase_start = now;
+}
+
+void semant_stats_flush()
+{
+   std::lock_guard<std::mutex> hold(stats_lock);
+   totals.add(semant_counters);
+   semant_counters = SemantCounters();
+}
+
+//
+// A class's counts are the difference its check makes; its deepest
+// scope is tracked afresh and folded back into the thread's.
+//
+ClassCost::ClassCost(Class_ c) : cls(c), start_counts(semant_counters)
+{
+   if (!semant_stats) return;
+   semant_counters.max_scope_depth = semant_counters.scope_depth;
+   start = Clock::now();
+}
+
+ClassCost::~ClassCost()
+{
+   if (!semant_stats) return;
+   ClassRecord r;
+   r.name = cls->get_class_name()->get_string();
+   r.seconds = seconds_since(start);
+   SemantCounters& now = semant_counters;
+   r.counts.class_lookups = now.class_lookups - start_counts.class_lookups;
+   r.counts.conformance_checks = now.conformance_checks - start_counts.conformance_checks;
+   r.counts.type_joins = now.type_joins - start_counts.type_joins;
+   r.counts.var_lookups = now.var_lookups - start_counts.var_lookups;
+   r.counts.scopes_searched = now.scopes_searched - start_counts.scopes_searched;
+   r.counts.dispatches = now.dispatches - start_counts.dispatches;
+   r.counts.max_scope_depth = now.max_scope_depth;
+   if (start_counts.max_scope_depth > now.max_scope_depth)
+      now.max_scope_depth = start_counts.max_scope_depth;
+   std::lock_guard<std::mutex> hold(stats_lock);
+   class_records.push_back(r);
+}
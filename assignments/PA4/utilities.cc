@@ -207,7 +207,7 @@ void dump_cool_token(ostream& out, int lineno, int token, YYSTYPE yylval)
           break;
         }
     }
-    out << endl;
+    out << "\n";
 }
 
 //
@@ -0,0 +1,549 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  bclower.cc
+//
+//  Lowering the typed AST to bytecode (cgen -b); see bytecode.h for
+//  the instruction set and coolvm.cc for the interpreter.
+//
+//  The class table is the one CgenClassTable builds for the MIPS
+//  backend, so tags, attribute offsets and dispatch slots are the same
+//  in both.  Registers are allocated like a stack: every expression is
+//  lowered into a register its parent picked, with the registers above
+//  `top' free for its own temporaries, and writes that register only as
+//  the last thing it does, so an assignment can evaluate its right-hand
+//  side straight into the variable.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include "cgen.h"
+#include "bytecode.h"
+
+extern int cgen_debug;
+extern Symbol Bool, Int, Main, main_meth, Object, self, SELF_TYPE, Str;
+
+#define MAX_REGS 0x10000
+
+class BcLowering {
+private:
+   std::unordered_map<std::string, int> string_ids;
+   std::unordered_map<HierFeature *, int> method_ids;
+   std::vector<int> init_ids;                  // by tag, -1 if none
+
+   // the function being lowered
+   BcFunction *fn;
+   CgenNodeP cls;
+   std::unordered_map<Symbol, int> attr_index;
+   std::vector<std::pair<Symbol, int> > locals;
+
+   int native(Symbol method);
+   void start_function(CgenNodeP c, const std::string& name, int nargs);
+   void lower_method(CgenNodeP c, method_class *m);
+   void lower_init(CgenNodeP c);
+   void lower_entry();
+
+public:
+   BcModule& m;
+   CgenClassTable& ct;
+   ClassHierarchy& h;
+   int top;                                    // first free register
+   int line;                                   // line of what is emitted
+
+   BcLowering(BcModule& module, CgenClassTable& table);
+   void lower_program();
+
+   int string_const(const std::string& s);
+   int emit(int op, int a, int b = 0, int c = 0);
+   int emit_imm(int op, int a, int imm);
+   int here() { return fn->code.size(); }
+   void patch(int pc, int target) { fn->code[pc].set_imm(target); }
+   int temp();
+
+   int tag_of(Symbol type) { return type == SELF_TYPE ? cls->get_tag() : h.lookup(type); }
+   int local(Symbol name);
+   int attribute(Symbol name) { return attr_index[name]; }
+   void bind(Symbol name, int reg) { locals.push_back(std::make_pair(name, reg)); }
+   void unbind() { locals.pop_back(); }
+
+   int operand(Expression e);
+   void default_value(Symbol type, int dst);
+   void binary(int op, Expression e1, Expression e2, int dst);
+   void call(int op, Expression recv, Expressions actual, int target, int dst, int at);
+};
+
+BcLowering::BcLowering(BcModule& module, CgenClassTable& table) :
+   fn(NULL), cls(NULL), m(module), ct(table), h(*class_hierarchy), top(0), line(0)
+{ }
+
+int BcLowering::string_const(const std::string& s)
+{
+   std::unordered_map<std::string, int>::iterator it = string_ids.find(s);
+   if (it != string_ids.end()) return it->second;
+   m.strings.push_back(s);
+   return string_ids[s] = m.strings.size() - 1;
+}
+
+int BcLowering::emit(int op, int a, int b, int c)
+{
+   BcInsn in;
+   in.op = op;
+   in.a = a;
+   in.b = b;
+   in.c = c;
+   fn->code.push_back(in);
+   fn->lines.push_back(line);
+   return fn->code.size() - 1;
+}
+
+int BcLowering::emit_imm(int op, int a, int imm)
+{
+   int pc = emit(op, a);
+   fn->code[pc].set_imm(imm);
+   return pc;
+}
+
+int BcLowering::temp()
+{
+   if (top + 1 >= MAX_REGS) {
+      cerr << "Method " << m.strings[fn->name] << " needs too many registers.\n";
+      exit(1);
+   }
+   if (top + 1 > fn->nregs) fn->nregs = top + 1;
+   return top++;
+}
+
+int BcLowering::local(Symbol name)
+{
+   for (int i = locals.size() - 1; i >= 0; i--)
+      if (locals[i].first == name) return locals[i].second;
+   return -1;
+}
+
+//
+// The register holding the value of `e': a variable's own, or a fresh
+// temporary `e' is lowered into.
+//
+int BcLowering::operand(Expression e)
+{
+   if (object_class *o = dynamic_cast<object_class *>(e)) {
+      if (o->name == self) return 0;
+      int r = local(o->name);
+      if (r >= 0) return r;
+   }
+   int t = temp();
+   e->lower(*this, t);
+   return t;
+}
+
+void BcLowering::default_value(Symbol type, int dst)
+{
+   if (type == Int)
+      emit_imm(OP_LOADI, dst, 0);
+   else if (type == Bool)
+      emit(OP_LOADB, dst, 0);
+   else if (type == Str)
+      emit_imm(OP_LOADS, dst, string_const(""));
+   else
+      emit(OP_LOADV, dst);
+}
+
+static bool is_empty(Expression e)
+{
+   return dynamic_cast<no_expr_class *>(e) != NULL;
+}
+
+//
+// A variable read as the left operand must be copied first if the right
+// operand can assign it; only constants and variables are known not to.
+//
+static bool has_no_effect(Expression e)
+{
+   return dynamic_cast<object_class *>(e) || dynamic_cast<int_const_class *>(e)
+      || dynamic_cast<bool_const_class *>(e) || dynamic_cast<string_const_class *>(e);
+}
+
+void BcLowering::binary(int op, Expression e1, Expression e2, int dst)
+{
+   int save = top;
+   int r1;
+   if (has_no_effect(e2))
+      r1 = operand(e1);
+   else
+      e1->lower(*this, r1 = temp());
+   int r2 = operand(e2);
+   emit(op, dst, r1, r2);
+   top = save;
+}
+
+//
+// The receiver goes in a fresh register with the arguments after it.
+// Arguments are evaluated before the receiver, left to right.
+//
+void BcLowering::call(int op, Expression recv, Expressions actual, int target, int dst, int at)
+{
+   int base = temp();
+   for (int i = actual->first(); actual->more(i); i = actual->next(i))
+      temp();
+   for (int i = actual->first(); actual->more(i); i = actual->next(i))
+      actual->nth(i)->lower(*this, base + 1 + i);
+   recv->lower(*this, base);
+   line = at;
+   emit(op, dst, base, target);
+   top = base;
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// Functions
+//
+//////////////////////////////////////////////////////////////////////
+
+int BcLowering::native(Symbol method)
+{
+   static const char *names[NATIVES] = {
+      "abort", "type_name", "copy", "out_string", "out_int",
+      "in_string", "in_int", "length", "concat", "substr"
+   };
+   for (int i = 0; i < NATIVES; i++)
+      if (strcmp(method->get_string(), names[i]) == 0) return i;
+   cerr << "No native method " << method << ".\n";
+   exit(1);
+}
+
+void BcLowering::start_function(CgenNodeP c, const std::string& name, int nargs)
+{
+   m.functions.push_back(BcFunction());
+   fn = &m.functions.back();
+   fn->name = string_const(name);
+   fn->file = string_const(c ? c->get_filename()->get_string() : "");
+   fn->nargs = nargs;
+   fn->nregs = 0;
+   top = 0;
+   temp();                                     // self
+   locals.clear();
+
+   cls = c;
+   attr_index.clear();
+   if (c == NULL) return;
+   std::vector<std::pair<int, HierFeature *> > layout;
+   h.attr_layout(c->get_tag(), layout);
+   for (size_t i = 0; i < layout.size(); i++)
+      attr_index[layout[i].second->name] = i;
+}
+
+void BcLowering::lower_method(CgenNodeP c, method_class *meth)
+{
+   std::string name = std::string(c->get_name()->get_string()) + "." + meth->name->get_string();
+   start_function(c, name, meth->formals->len());
+   for (int i = meth->formals->first(); meth->formals->more(i); i = meth->formals->next(i))
+      bind(((formal_class *) meth->formals->nth(i))->name, temp());
+   line = meth->get_line_number();
+   int r = operand(meth->expr);
+   emit(OP_RET, r);
+}
+
+//
+// A class's initializer runs its parent's, then its own attributes'
+// initializers in order, and returns self.
+//
+void BcLowering::lower_init(CgenNodeP c)
+{
+   start_function(c, std::string(c->get_name()->get_string()) + "_init", 0);
+   line = c->get_line_number();
+   CgenNodeP p = c->get_parentnd();
+   if (p != NULL && init_ids[p->get_tag()] >= 0) {
+      int base = temp();
+      emit(OP_MOVE, base, 0);
+      emit(OP_CALLS, base, base, init_ids[p->get_tag()]);
+      top = base;
+   }
+   Features fs = c->features;
+   for (int i = fs->first(); fs->more(i); i = fs->next(i)) {
+      attr_class *a = dynamic_cast<attr_class *>(fs->nth(i));
+      if (a == NULL || is_empty(a->init)) continue;
+      line = a->get_line_number();
+      int save = top;
+      emit(OP_SETATTR, attribute(a->name), operand(a->init));
+      top = save;
+   }
+   emit(OP_RET, 0);
+}
+
+void BcLowering::lower_entry()
+{
+   start_function(NULL, "_start", 0);
+   int r = temp();
+   emit(OP_NEW, r, h.lookup(Main));
+   int slot = h.find_slot(h.lookup(Main), main_meth);
+   emit(OP_CALL, r, r, slot);
+   emit(OP_RET, r);
+}
+
+//
+// Function ids are handed out first, so calls and dispatch tables can
+// name functions that are lowered later.
+//
+void BcLowering::lower_program()
+{
+   int n = h.size();
+   int next = NATIVES;
+   init_ids.assign(n, -1);
+   for (int t = 0; t < n; t++) {
+      CgenNodeP c = ct.node(t);
+      if (c->basic()) continue;
+      Features fs = c->features;
+      bool inits = c->get_parentnd() && init_ids[c->get_parentnd()->get_tag()] >= 0;
+      for (int i = fs->first(); fs->more(i); i = fs->next(i))
+         if (attr_class *a = dynamic_cast<attr_class *>(fs->nth(i)))
+            inits = inits || !is_empty(a->init);
+      for (size_t k = 0; k < h[t].methods.size(); k++)
+         method_ids[&h[t].methods[k]] = next++;
+      if (inits) init_ids[t] = next++;
+   }
+
+   m.classes.resize(n);
+   for (int t = 0; t < n; t++) {
+      BcClass& bc = m.classes[t];
+      bc.name = string_const(h[t].name->get_string());
+      bc.parent = h[t].parent_index;
+      bc.last = h[t].last;
+      bc.init = init_ids[t];
+
+      std::vector<std::pair<int, HierFeature *> > layout;
+      h.attr_layout(t, layout);
+      for (size_t i = 0; i < layout.size(); i++) {
+         Symbol type = layout[i].second->type;
+         bc.attrs.push_back(type == Int ? DEFAULT_INT : type == Bool ? DEFAULT_BOOL
+                            : type == Str ? DEFAULT_STRING : DEFAULT_VOID);
+      }
+      for (int s = 0; s < h[t].method_count; s++) {
+         HierMethodRef r = h.dispatch(t, s);
+         bc.dispatch.push_back(h[r.cls].basic ? native(r.method->name) : method_ids[r.method]);
+      }
+   }
+   m.object_tag = h.lookup(Object);
+   m.int_tag = h.lookup(Int);
+   m.bool_tag = h.lookup(Bool);
+   m.string_tag = h.lookup(Str);
+
+   // The same order the ids were handed out in.
+   for (int t = 0; t < n; t++) {
+      CgenNodeP c = ct.node(t);
+      if (c->basic()) continue;
+      Features fs = c->features;
+      for (size_t k = 0; k < h[t].methods.size(); k++)
+         for (int i = fs->first(); fs->more(i); i = fs->next(i)) {
+            method_class *meth = dynamic_cast<method_class *>(fs->nth(i));
+            if (meth && meth->name == h[t].methods[k].name) lower_method(c, meth);
+         }
+      if (init_ids[t] >= 0) lower_init(c);
+   }
+   m.entry = NATIVES + m.functions.size();
+   lower_entry();
+}
+
+void bytecode_program(CgenClassTableP table, ostream& os)
+{
+   BcModule module;
+   BcLowering lowering(module, *table);
+   lowering.lower_program();
+   if (cgen_debug) module.dump(cerr);
+   module.write(os);
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// Expressions
+//
+//////////////////////////////////////////////////////////////////////
+
+void assign_class::lower(BcLowering& L, int dst)
+{
+   int r = L.local(name);
+   if (r >= 0) {
+      expr->lower(L, r);
+      if (dst != r) L.emit(OP_MOVE, dst, r);
+      return;
+   }
+   int save = L.top;
+   int v = L.operand(expr);
+   L.emit(OP_SETATTR, L.attribute(name), v);
+   if (dst != v) L.emit(OP_MOVE, dst, v);
+   L.top = save;
+}
+
+void static_dispatch_class::lower(BcLowering& L, int dst)
+{
+   int t = L.tag_of(type_name);
+   int fid = L.m.classes[t].dispatch[L.h.find_slot(t, name)];
+   L.call(OP_CALLS, expr, actual, fid, dst, get_line_number());
+}
+
+void dispatch_class::lower(BcLowering& L, int dst)
+{
+   int slot = L.h.find_slot(L.tag_of(expr->get_type()), name);
+   L.call(OP_CALL, expr, actual, slot, dst, get_line_number());
+}
+
+void cond_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   int p = L.operand(pred);
+   L.top = save;
+   int to_else = L.emit_imm(OP_JF, p, 0);
+   then_exp->lower(L, dst);
+   int to_end = L.emit_imm(OP_JMP, 0, 0);
+   L.patch(to_else, L.here());
+   else_exp->lower(L, dst);
+   L.patch(to_end, L.here());
+}
+
+void loop_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   int start = L.here();
+   int p = L.operand(pred);
+   int to_end = L.emit_imm(OP_JF, p, 0);
+   L.top = save;
+   body->lower(L, L.temp());
+   L.top = save;
+   L.emit_imm(OP_JMP, 0, start);
+   L.patch(to_end, L.here());
+   L.emit(OP_LOADV, dst);
+}
+
+//
+// Branches are tried from the deepest class up, so the first whose
+// subtree holds the value's tag is the closest ancestor.
+//
+void typcase_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   int v = L.operand(expr);
+   int tag = L.temp();
+   L.line = get_line_number();
+   L.emit(OP_TAG, tag, v);
+
+   std::vector<branch_class *> branches;
+   for (int i = cases->first(); cases->more(i); i = cases->next(i))
+      branches.push_back((branch_class *) cases->nth(i));
+   for (size_t i = 1; i < branches.size(); i++)
+      for (size_t k = i; k > 0 && L.h[L.tag_of(branches[k]->type_decl)].depth >
+                                  L.h[L.tag_of(branches[k - 1]->type_decl)].depth; k--)
+         std::swap(branches[k], branches[k - 1]);
+
+   std::vector<int> to_end;
+   for (size_t i = 0; i < branches.size(); i++) {
+      int t = L.tag_of(branches[i]->type_decl);
+      L.emit(OP_INRANGE, tag, t, L.h[t].last);
+      int to_next = L.emit_imm(OP_JMP, 0, 0);
+      int var = L.temp();
+      L.emit(OP_MOVE, var, v);
+      L.bind(branches[i]->name, var);
+      branches[i]->expr->lower(L, dst);
+      L.unbind();
+      L.top = var;
+      to_end.push_back(L.emit_imm(OP_JMP, 0, 0));
+      L.patch(to_next, L.here());
+   }
+   L.emit(OP_CASEABORT, tag);
+   for (size_t i = 0; i < to_end.size(); i++)
+      L.patch(to_end[i], L.here());
+   L.top = save;
+}
+
+void block_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   for (int i = body->first(); body->more(i); i = body->next(i)) {
+      if (body->more(body->next(i))) {
+         body->nth(i)->lower(L, L.temp());
+         L.top = save;
+      } else
+         body->nth(i)->lower(L, dst);
+   }
+}
+
+void let_class::lower(BcLowering& L, int dst)
+{
+   int var = L.temp();
+   if (is_empty(init))
+      L.default_value(type_decl, var);
+   else
+      init->lower(L, var);
+   L.bind(identifier, var);
+   body->lower(L, dst);
+   L.unbind();
+   L.top = var;
+}
+
+void plus_class::lower(BcLowering& L, int dst)   { L.binary(OP_ADD, e1, e2, dst); }
+void sub_class::lower(BcLowering& L, int dst)    { L.binary(OP_SUB, e1, e2, dst); }
+void mul_class::lower(BcLowering& L, int dst)    { L.binary(OP_MUL, e1, e2, dst); }
+void divide_class::lower(BcLowering& L, int dst) { L.binary(OP_DIV, e1, e2, dst); }
+void lt_class::lower(BcLowering& L, int dst)     { L.binary(OP_LT, e1, e2, dst); }
+void eq_class::lower(BcLowering& L, int dst)     { L.binary(OP_EQ, e1, e2, dst); }
+void leq_class::lower(BcLowering& L, int dst)    { L.binary(OP_LE, e1, e2, dst); }
+
+void neg_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   L.emit(OP_NEG, dst, L.operand(e1));
+   L.top = save;
+}
+
+void comp_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   L.emit(OP_NOT, dst, L.operand(e1));
+   L.top = save;
+}
+
+void isvoid_class::lower(BcLowering& L, int dst)
+{
+   int save = L.top;
+   L.emit(OP_ISVOID, dst, L.operand(e1));
+   L.top = save;
+}
+
+void int_const_class::lower(BcLowering& L, int dst)
+{
+   L.emit_imm(OP_LOADI, dst, atoi(token->get_string()));
+}
+
+void string_const_class::lower(BcLowering& L, int dst)
+{
+   L.emit_imm(OP_LOADS, dst, L.string_const(std::string(token->get_string(), token->get_len())));
+}
+
+void bool_const_class::lower(BcLowering& L, int dst)
+{
+   L.emit(OP_LOADB, dst, val ? 1 : 0);
+}
+
+void new__class::lower(BcLowering& L, int dst)
+{
+   if (type_name == SELF_TYPE)
+      L.emit(OP_NEWSELF, dst);
+   else if (type_name == Int || type_name == Bool || type_name == Str)
+      L.default_value(type_name, dst);
+   else
+      L.emit(OP_NEW, dst, L.tag_of(type_name));
+}
+
+void no_expr_class::lower(BcLowering& L, int dst)
+{
+   L.emit(OP_LOADV, dst);
+}
+
+void object_class::lower(BcLowering& L, int dst)
+{
+   int r = name == self ? 0 : L.local(name);
+   if (r < 0)
+      L.emit(OP_GETATTR, dst, L.attribute(name));
+   else if (r != dst)
+      L.emit(OP_MOVE, dst, r);
+}
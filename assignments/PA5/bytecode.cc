@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  bytecode.cc
+//
+//  Writing, reading and listing bytecode modules.  The image is a
+//  magic line followed by 32-bit words in the byte order of the machine
+//  that wrote it; a string is its length and its bytes, a vector its
+//  size and its elements.  cgen and coolvm both link this file, so it
+//  must not refer to the AST.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "bytecode.h"
+
+static const char magic[] = "COOLVM1\n";
+
+const char *bc_op_names[] = {
+#define BC_NAME(op) #op,
+   BC_OPS(BC_NAME)
+#undef BC_NAME
+};
+
+static void put(ostream& s, int32_t w)
+{
+   s.write((const char *) &w, sizeof w);
+}
+
+static void put_ints(ostream& s, const std::vector<int>& v)
+{
+   put(s, v.size());
+   for(size_t i = 0; i < v.size(); i++) put(s, v[i]);
+}
+
+void BcModule::write(ostream& s)
+{
+   s.write(magic, sizeof magic - 1);
+   put(s, strings.size());
+   for(size_t i = 0; i < strings.size(); i++) {
+      put(s, strings[i].size());
+      s.write(strings[i].data(), strings[i].size());
+   }
+   put(s, classes.size());
+   for(size_t i = 0; i < classes.size(); i++) {
+      BcClass& c = classes[i];
+      put(s, c.name);
+      put(s, c.parent);
+      put(s, c.last);
+      put(s, c.init);
+      put_ints(s, c.attrs);
+      put_ints(s, c.dispatch);
+   }
+   put(s, functions.size());
+   for(size_t i = 0; i < functions.size(); i++) {
+      BcFunction& f = functions[i];
+      put(s, f.name);
+      put(s, f.file);
+      put(s, f.nargs);
+      put(s, f.nregs);
+      put(s, f.code.size());
+      s.write((const char *) f.code.data(), f.code.size() * sizeof(BcInsn));
+      put_ints(s, f.lines);
+   }
+   put(s, object_tag);
+   put(s, int_tag);
+   put(s, bool_tag);
+   put(s, string_tag);
+   put(s, entry);
+}
+
+//
+// Reading stops at the first short read; every count is checked
+// against what is left of the file before anything is allocated.
+//
+class ImageReader {
+private:
+   FILE *f;
+   long left;
+public:
+   bool ok;
+   ImageReader(FILE *file, long size) : f(file), left(size), ok(true) { }
+
+   bool bytes(void *p, size_t n)
+   {
+      if (!ok || (long) n > left || fread(p, 1, n, f) != n) return ok = false;
+      left -= n;
+      return true;
+   }
+   int get()
+   {
+      int32_t w = 0;
+      bytes(&w, sizeof w);
+      return w;
+   }
+   int count(size_t unit)
+   {
+      int n = get();
+      if (n < 0 || (long) (n * unit) > left) ok = false;
+      return ok ? n : 0;
+   }
+   void ints(std::vector<int>& v)
+   {
+      v.resize(count(sizeof(int32_t)));
+      for(size_t i = 0; i < v.size(); i++) v[i] = get();
+   }
+};
+
+bool BcModule::read(FILE *f)
+{
+   if (fseek(f, 0, SEEK_END) != 0) return false;
+   long size = ftell(f);
+   rewind(f);
+
+   ImageReader r(f, size);
+   char m[sizeof magic - 1];
+   if (!r.bytes(m, sizeof m) || memcmp(m, magic, sizeof m) != 0) return false;
+
+   strings.resize(r.count(sizeof(int32_t)));
+   for(size_t i = 0; i < strings.size() && r.ok; i++) {
+      std::vector<char> buf(r.count(1));
+      r.bytes(buf.data(), buf.size());
+      strings[i].assign(buf.begin(), buf.end());
+   }
+   classes.resize(r.count(6 * sizeof(int32_t)));
+   for(size_t i = 0; i < classes.size() && r.ok; i++) {
+      BcClass& c = classes[i];
+      c.name = r.get();
+      c.parent = r.get();
+      c.last = r.get();
+      c.init = r.get();
+      r.ints(c.attrs);
+      r.ints(c.dispatch);
+   }
+   functions.resize(r.count(6 * sizeof(int32_t)));
+   for(size_t i = 0; i < functions.size() && r.ok; i++) {
+      BcFunction& fn = functions[i];
+      fn.name = r.get();
+      fn.file = r.get();
+      fn.nargs = r.get();
+      fn.nregs = r.get();
+      fn.code.resize(r.count(sizeof(BcInsn)));
+      r.bytes(fn.code.data(), fn.code.size() * sizeof(BcInsn));
+      r.ints(fn.lines);
+   }
+   object_tag = r.get();
+   int_tag = r.get();
+   bool_tag = r.get();
+   string_tag = r.get();
+   entry = r.get();
+   return r.ok;
+}
+
+//
+// A listing of the module, one instruction per line, for cgen -c.
+//
+void BcModule::dump(ostream& s)
+{
+   for(size_t i = 0; i < classes.size(); i++) {
+      BcClass& c = classes[i];
+      s << "# class " << i << " " << strings[c.name] << " parent " << c.parent
+        << " last " << c.last << " init " << c.init << " attrs " << c.attrs.size()
+        << " dispatch";
+      for(size_t k = 0; k < c.dispatch.size(); k++) s << " " << c.dispatch[k];
+      s << "\n";
+   }
+   for(size_t i = 0; i < functions.size(); i++) {
+      BcFunction& fn = functions[i];
+      s << "# function " << NATIVES + i << " " << strings[fn.name]
+        << " args " << fn.nargs << " regs " << fn.nregs << "\n";
+      for(size_t pc = 0; pc < fn.code.size(); pc++) {
+         BcInsn& in = fn.code[pc];
+         s << "#   " << pc << "\t" << bc_op_names[in.op] << "\t" << in.a << " " << in.b
+           << " " << in.c << "\t(imm " << in.imm() << ", line " << fn.lines[pc] << ")\n";
+      }
+   }
+}
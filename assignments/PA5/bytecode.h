@@ -0,0 +1,135 @@
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  bytecode.h
+//
+//  The bytecode cgen -b writes and coolvm runs.
+//
+//  A module is the whole program: its string constants, one record per
+//  class in tag order, and its functions, one per method with a body
+//  and one per class whose attributes have initializers.  The methods
+//  of the basic classes are native to the interpreter and have the
+//  function ids below NATIVES; function i of the module has id
+//  NATIVES + i.
+//
+//  Functions work on registers.  A call's receiver and arguments are
+//  placed in consecutive registers of the caller, and the callee's
+//  registers start at the receiver: r0 is self, r1.. the formals, then
+//  its locals and temporaries, all void on entry.  Every instruction is
+//  an opcode and three 16-bit operands; jumps and integer constants use
+//  b and c together as one 32-bit immediate.
+//
+//  Instructions carry the source line they come from so the runtime
+//  errors that report one (dispatch to void, case on void) can.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "cool-io.h"
+
+//
+// Opcodes, with what they do.  R[x] is register x of the current
+// function, K[x] string constant x.
+//
+#define BC_OPS(X)                                                     \
+   X(MOVE)      /* R[a] = R[b]                                     */ \
+   X(LOADI)     /* R[a] = Int imm                                  */ \
+   X(LOADB)     /* R[a] = Bool b                                   */ \
+   X(LOADS)     /* R[a] = K[imm]                                   */ \
+   X(LOADV)     /* R[a] = void                                     */ \
+   X(GETATTR)   /* R[a] = attribute b of self                      */ \
+   X(SETATTR)   /* attribute a of self = R[b]                      */ \
+   X(ADD)       /* R[a] = R[b] + R[c], likewise SUB, MUL and DIV   */ \
+   X(SUB)                                                             \
+   X(MUL)                                                             \
+   X(DIV)                                                             \
+   X(NEG)       /* R[a] = ~R[b]                                    */ \
+   X(LT)        /* R[a] = R[b] < R[c]                              */ \
+   X(LE)        /* R[a] = R[b] <= R[c]                             */ \
+   X(EQ)        /* R[a] = R[b] = R[c]                              */ \
+   X(NOT)       /* R[a] = not R[b]                                 */ \
+   X(ISVOID)    /* R[a] = isvoid R[b]                              */ \
+   X(JMP)       /* goto imm                                        */ \
+   X(JT)        /* if R[a] goto imm                                */ \
+   X(JF)        /* if not R[a] goto imm                            */ \
+   X(NEW)       /* R[a] = new class b, initialized                 */ \
+   X(NEWSELF)   /* R[a] = new SELF_TYPE                            */ \
+   X(CALL)      /* R[a] = R[b].<dispatch slot c>(R[b+1], ...)      */ \
+   X(CALLS)     /* R[a] = R[b].<function c>(R[b+1], ...)           */ \
+   X(RET)       /* return R[a]                                     */ \
+   X(TAG)       /* R[a] = class tag of R[b], which is not void     */ \
+   X(INRANGE)   /* skip the next instruction if b <= R[a] <= c     */ \
+   X(CASEABORT) /* no branch matches class tag R[a]                */
+
+enum BcOp {
+#define BC_ENUM(op) OP_##op,
+   BC_OPS(BC_ENUM)
+#undef BC_ENUM
+   BC_OP_COUNT
+};
+
+extern const char *bc_op_names[];
+
+struct BcInsn {
+   uint16_t op, a, b, c;
+
+   int32_t imm() const { return (int32_t) ((uint32_t) b | ((uint32_t) c << 16)); }
+   void set_imm(int32_t v) { b = (uint32_t) v & 0xffff; c = (uint32_t) v >> 16; }
+};
+
+//
+// The methods of the basic classes, by function id.
+//
+enum BcNative {
+   NATIVE_ABORT,
+   NATIVE_TYPE_NAME,
+   NATIVE_COPY,
+   NATIVE_OUT_STRING,
+   NATIVE_OUT_INT,
+   NATIVE_IN_STRING,
+   NATIVE_IN_INT,
+   NATIVE_LENGTH,
+   NATIVE_CONCAT,
+   NATIVE_SUBSTR,
+   NATIVES
+};
+
+// What an attribute holds before the initializers run.
+enum BcDefault { DEFAULT_VOID, DEFAULT_INT, DEFAULT_BOOL, DEFAULT_STRING };
+
+struct BcClass {
+   int name;                      // string constant
+   int parent;                    // tag, -1 for Object
+   int last;                      // last tag of the subtree
+   int init;                      // function id, -1 if nothing to run
+   std::vector<int> attrs;        // BcDefault of every attribute
+   std::vector<int> dispatch;     // function id of every slot
+};
+
+struct BcFunction {
+   int name;                      // string constant "Class.method"
+   int file;                      // string constant
+   int nargs;                     // formals, not counting self
+   int nregs;
+   std::vector<BcInsn> code;
+   std::vector<int> lines;        // source line of every instruction
+};
+
+struct BcModule {
+   std::vector<std::string> strings;
+   std::vector<BcClass> classes;
+   std::vector<BcFunction> functions;
+   int object_tag, int_tag, bool_tag, string_tag;
+   int entry;                     // function that runs (new Main).main()
+
+   void write(ostream& s);
+   bool read(FILE *f);
+   void dump(ostream& s);
+};
+
+#endif
@@ -4,18 +4,33 @@
 #include "cool-io.h"  //includes iostream
 #include "cool-tree.h"
 #include "cgen_gc.h"
+#include "outbuf.h"
+#include "hierarchy.h"
 
 extern int optind;            // for option processing
 extern char *out_filename;    // name of output assembly
+extern int cgen_bytecode;     // bytecode for coolvm instead (-b)
+extern int cgen_optimize;     // fold constants and optimize (-O)
 extern Program ast_root;             // root of the abstract syntax tree
 FILE *ast_file = stdin;       // we read the AST from standard input
 extern int ast_yyparse(void); // entry point to the AST parser
+extern ClassHierarchy *class_hierarchy; // handed over by semant -h, if any
 
 int cool_yydebug;     // not used, but needed to link with handle_flags
 char *curr_filename;
 
 void handle_flags(int argc, char *argv[]);
 
+static void generate(ostream& s)
+{
+  if (cgen_optimize)
+      ast_root->fold();
+  if (cgen_bytecode)
+      ast_root->bytecode(s);
+  else
+      ast_root->cgen(s);
+}
+
 int main(int argc, char *argv[]) {
   int firstfile_index;
 
@@ -27,24 +42,28 @@ int main(int argc, char *argv[]) {
       if (dot) *dot = '\0'; // strip off file extension
       out_filename = new char[strlen(argv[optind])+8];
       strcpy(out_filename, argv[optind]);
-      strcat(out_filename, ".s");
+      strcat(out_filename, cgen_bytecode ? ".cvm" : ".s");
   }
 
   // 
   // Don't touch the output file until we know that earlier phases of the
   // compiler have succeeded.
   //
+  class_hierarchy = ClassHierarchy::read(ast_file);
   ast_yyparse();
 
   if (out_filename) {
-      ofstream s(out_filename);
-      if (!s) {
+      OutBuf buf(out_filename);
+      if (!buf.is_open()) {
 	  cerr << "Cannot open output file " << out_filename << endl;
 	  exit(1);
       }
-      ast_root->cgen(s);
+      ostream s(&buf);
+      generate(s);
   } else {
-      ast_root->cgen(cout);
+      OutBuf buf(1);
+      ostream s(&buf);
+      generate(s);
   }
 }
 
@@ -24,9 +24,20 @@
 
 #include "cgen.h"
 #include "cgen_gc.h"
+#include "escape.h"
+#include "inline.h"
+#include "outbuf.h"
+#include "optimize.h"
+#include "mips.h"
+#include "peephole.h"
+#include "regalloc.h"
+#include <map>
+#include <unordered_map>
 
 extern void emit_string_constant(ostream& str, char *s);
 extern int cgen_debug;
+extern bool disable_reg_alloc;
+extern int cgen_optimize;
 
 //
 // Three symbols from the semantic analyzer (semant.cc) are used.
@@ -116,6 +127,10 @@ static char *gc_collect_names[] =
 BoolConst falsebool(FALSE);
 BoolConst truebool(TRUE);
 
+// The class hierarchy semant handed over with -h (read by cgen-phase.cc
+// ahead of the AST), or NULL to have CgenClassTable build it.
+ClassHierarchy *class_hierarchy;
+
 //*********************************************************
 //
 // Define method for code generation
@@ -124,8 +139,8 @@ BoolConst truebool(TRUE);
 // `cgtest.cc'. cgen takes an `ostream' to which the assembly will be
 // emmitted, and it passes this and the class list of the
 // code generator tree to the constructor for `CgenClassTable'.
-// That constructor performs all of the work of the code
-// generator.
+// That constructor builds the class table, and its code()
+// performs the rest of the work of the code generator.
 //
 //*********************************************************
 
@@ -136,105 +151,116 @@ void program_class::cgen(ostream &os)
 
   initialize_constants();
   CgenClassTable *codegen_classtable = new CgenClassTable(classes,os);
+  codegen_classtable->code();
 
   os << "\n# end of generated code\n";
 }
 
+//
+// The bytecode backend (cgen -b) shares the class table and lowers the
+// methods itself; see bclower.cc.
+//
+void program_class::bytecode(ostream &os)
+{
+  initialize_constants();
+  CgenClassTable *codegen_classtable = new CgenClassTable(classes,os);
+  bytecode_program(codegen_classtable, os);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 //
 //  emit_* procedures
 //
-//  emit_X  writes code for operation "X" to the output stream.
-//  There is an emit_X for each opcode X, as well as emit_ functions
-//  for generating names according to the naming conventions (see emit.h)
-//  and calls to support functions defined in the trap handler.
+//  emit_X  appends an instruction "X" to a function's MipsCode.  There
+//  is an emit_X for each opcode X, as well as emit_ functions for
+//  calls to support functions defined in the trap handler.  MipsCode
+//  prints them as text at the end (see mips.h); the emit_*_ref
+//  procedures write names according to the naming conventions (see
+//  emit.h) straight to a stream, for the data.
 //
-//  Register names and addresses are passed as strings.  See `emit.h'
-//  for symbolic names you can use to refer to the strings.
+//  Register names are passed as strings.  See `emit.h' for symbolic
+//  names you can use to refer to the strings.
 //
 //////////////////////////////////////////////////////////////////////////////
 
-static void emit_load(char *dest_reg, int offset, char *source_reg, ostream& s)
-{
-  s << LW << dest_reg << " " << offset * WORD_SIZE << "(" << source_reg << ")" 
-    << endl;
-}
+static void emit_load(char *dest_reg, int offset, char *source_reg, MipsCode& s)
+{ s.add(MipsInsn(MIPS_LW, mips_reg(dest_reg), mips_reg(source_reg), -1, offset * WORD_SIZE)); }
 
-static void emit_store(char *source_reg, int offset, char *dest_reg, ostream& s)
-{
-  s << SW << source_reg << " " << offset * WORD_SIZE << "(" << dest_reg << ")"
-      << endl;
-}
+static void emit_store(char *source_reg, int offset, char *dest_reg, MipsCode& s)
+{ s.add(MipsInsn(MIPS_SW, mips_reg(source_reg), mips_reg(dest_reg), -1, offset * WORD_SIZE)); }
 
-static void emit_load_imm(char *dest_reg, int val, ostream& s)
-{ s << LI << dest_reg << " " << val << endl; }
+static void emit_load_imm(char *dest_reg, int val, MipsCode& s)
+{ s.add(MipsInsn(MIPS_LI, mips_reg(dest_reg), -1, -1, val)); }
 
-static void emit_load_address(char *dest_reg, char *address, ostream& s)
-{ s << LA << dest_reg << " " << address << endl; }
+static void emit_load_address(char *dest_reg, const MipsAddr& address, MipsCode& s)
+{ s.add(MipsInsn(MIPS_LA, mips_reg(dest_reg), -1, -1, 0, address)); }
 
-static void emit_partial_load_address(char *dest_reg, ostream& s)
-{ s << LA << dest_reg << " "; }
+static void emit_load_bool(char *dest, const BoolConst& b, MipsCode& s)
+{ emit_load_address(dest, MipsAddr::bool_const(b.get_val()), s); }
 
-static void emit_load_bool(char *dest, const BoolConst& b, ostream& s)
-{
-  emit_partial_load_address(dest,s);
-  b.code_ref(s);
-  s << endl;
-}
+static void emit_load_string(char *dest, StringEntry *str, MipsCode& s)
+{ emit_load_address(dest, MipsAddr::str_const(str), s); }
 
-static void emit_load_string(char *dest, StringEntry *str, ostream& s)
-{
-  emit_partial_load_address(dest,s);
-  str->code_ref(s);
-  s << endl;
-}
+static void emit_load_int(char *dest, IntEntry *i, MipsCode& s)
+{ emit_load_address(dest, MipsAddr::int_const(i), s); }
 
-static void emit_load_int(char *dest, IntEntry *i, ostream& s)
-{
-  emit_partial_load_address(dest,s);
-  i->code_ref(s);
-  s << endl;
-}
+static void emit_move(char *dest_reg, char *source_reg, MipsCode& s)
+{ s.add(MipsInsn(MIPS_MOVE, mips_reg(dest_reg), mips_reg(source_reg))); }
+
+static void emit_neg(char *dest, char *src1, MipsCode& s)
+{ s.add(MipsInsn(MIPS_NEG, mips_reg(dest), mips_reg(src1))); }
+
+static void emit_arith(MipsOp op, char *dest, char *src1, char *src2, MipsCode& s)
+{ s.add(MipsInsn(op, mips_reg(dest), mips_reg(src1), mips_reg(src2))); }
+
+static void emit_add(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_ADD, dest, src1, src2, s); }
+
+static void emit_addu(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_ADDU, dest, src1, src2, s); }
 
-static void emit_move(char *dest_reg, char *source_reg, ostream& s)
-{ s << MOVE << dest_reg << " " << source_reg << endl; }
+static void emit_addiu(char *dest, char *src1, int imm, MipsCode& s)
+{ s.add(MipsInsn(MIPS_ADDIU, mips_reg(dest), mips_reg(src1), -1, imm)); }
 
-static void emit_neg(char *dest, char *src1, ostream& s)
-{ s << NEG << dest << " " << src1 << endl; }
+static void emit_div(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_DIV, dest, src1, src2, s); }
 
-static void emit_add(char *dest, char *src1, char *src2, ostream& s)
-{ s << ADD << dest << " " << src1 << " " << src2 << endl; }
+static void emit_mul(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_MUL, dest, src1, src2, s); }
 
-static void emit_addu(char *dest, char *src1, char *src2, ostream& s)
-{ s << ADDU << dest << " " << src1 << " " << src2 << endl; }
+static void emit_sub(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_SUB, dest, src1, src2, s); }
 
-static void emit_addiu(char *dest, char *src1, int imm, ostream& s)
-{ s << ADDIU << dest << " " << src1 << " " << imm << endl; }
+static void emit_slt(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_SLT, dest, src1, src2, s); }
 
-static void emit_div(char *dest, char *src1, char *src2, ostream& s)
-{ s << DIV << dest << " " << src1 << " " << src2 << endl; }
+static void emit_sle(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_SLE, dest, src1, src2, s); }
 
-static void emit_mul(char *dest, char *src1, char *src2, ostream& s)
-{ s << MUL << dest << " " << src1 << " " << src2 << endl; }
+static void emit_seq(char *dest, char *src1, char *src2, MipsCode& s)
+{ emit_arith(MIPS_SEQ, dest, src1, src2, s); }
 
-static void emit_sub(char *dest, char *src1, char *src2, ostream& s)
-{ s << SUB << dest << " " << src1 << " " << src2 << endl; }
+static void emit_xori(char *dest, char *src1, int imm, MipsCode& s)
+{ s.add(MipsInsn(MIPS_XORI, mips_reg(dest), mips_reg(src1), -1, imm)); }
 
-static void emit_sll(char *dest, char *src1, int num, ostream& s)
-{ s << SLL << dest << " " << src1 << " " << num << endl; }
+static void emit_sll(char *dest, char *src1, int num, MipsCode& s)
+{ s.add(MipsInsn(MIPS_SLL, mips_reg(dest), mips_reg(src1), -1, num)); }
 
-static void emit_jalr(char *dest, ostream& s)
-{ s << JALR << "\t" << dest << endl; }
+static void emit_jalr(char *dest, MipsCode& s)
+{ s.add(MipsInsn(MIPS_JALR, -1, mips_reg(dest))); }
 
-static void emit_jal(char *address,ostream &s)
-{ s << JAL << address << endl; }
+static void emit_jal(const MipsAddr& address, MipsCode& s)
+{ s.add(MipsInsn(MIPS_JAL, -1, -1, -1, 0, address)); }
 
-static void emit_return(ostream& s)
-{ s << RET << endl; }
+static void emit_jal(char *address, MipsCode& s)
+{ emit_jal(MipsAddr::named(address), s); }
 
-static void emit_gc_assign(ostream& s)
-{ s << JAL << "_GenGC_Assign" << endl; }
+static void emit_return(MipsCode& s)
+{ s.add(MipsInsn(MIPS_JR, -1, MIPS_RA)); }
+
+static void emit_gc_assign(MipsCode& s)
+{ emit_jal("_GenGC_Assign", s); }
 
 static void emit_disptable_ref(Symbol sym, ostream& s)
 {  s << sym << DISPTAB_SUFFIX; }
@@ -242,81 +268,49 @@ static void emit_disptable_ref(Symbol sym, ostream& s)
 static void emit_init_ref(Symbol sym, ostream& s)
 { s << sym << CLASSINIT_SUFFIX; }
 
-static void emit_label_ref(int l, ostream &s)
-{ s << "label" << l; }
-
 static void emit_protobj_ref(Symbol sym, ostream& s)
 { s << sym << PROTOBJ_SUFFIX; }
 
 static void emit_method_ref(Symbol classname, Symbol methodname, ostream& s)
 { s << classname << METHOD_SEP << methodname; }
 
-static void emit_label_def(int l, ostream &s)
-{
-  emit_label_ref(l,s);
-  s << ":" << endl;
-}
+static void emit_label_def(int l, MipsCode& s)
+{ s.add(MipsInsn(MIPS_LABEL, -1, -1, -1, 0, MipsAddr::label(l))); }
 
-static void emit_beqz(char *source, int label, ostream &s)
+static void emit_compare_branch(MipsOp op, char *src1, char *src2, int label, MipsCode& s)
 {
-  s << BEQZ << source << " ";
-  emit_label_ref(label,s);
-  s << endl;
+  s.add(MipsInsn(op, -1, mips_reg(src1), src2 ? mips_reg(src2) : -1, 0,
+                 MipsAddr::label(label)));
 }
 
-static void emit_beq(char *src1, char *src2, int label, ostream &s)
-{
-  s << BEQ << src1 << " " << src2 << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_beqz(char *source, int label, MipsCode& s)
+{ emit_compare_branch(MIPS_BEQZ, source, NULL, label, s); }
 
-static void emit_bne(char *src1, char *src2, int label, ostream &s)
-{
-  s << BNE << src1 << " " << src2 << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_beq(char *src1, char *src2, int label, MipsCode& s)
+{ emit_compare_branch(MIPS_BEQ, src1, src2, label, s); }
 
-static void emit_bleq(char *src1, char *src2, int label, ostream &s)
-{
-  s << BLEQ << src1 << " " << src2 << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_bne(char *src1, char *src2, int label, MipsCode& s)
+{ emit_compare_branch(MIPS_BNE, src1, src2, label, s); }
 
-static void emit_blt(char *src1, char *src2, int label, ostream &s)
-{
-  s << BLT << src1 << " " << src2 << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_bleq(char *src1, char *src2, int label, MipsCode& s)
+{ emit_compare_branch(MIPS_BLE, src1, src2, label, s); }
 
-static void emit_blti(char *src1, int imm, int label, ostream &s)
-{
-  s << BLT << src1 << " " << imm << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_blt(char *src1, char *src2, int label, MipsCode& s)
+{ emit_compare_branch(MIPS_BLT, src1, src2, label, s); }
 
-static void emit_bgti(char *src1, int imm, int label, ostream &s)
-{
-  s << BGT << src1 << " " << imm << " ";
-  emit_label_ref(label,s);
-  s << endl;
-}
+static void emit_blti(char *src1, int imm, int label, MipsCode& s)
+{ s.add(MipsInsn(MIPS_BLT, -1, mips_reg(src1), -1, imm, MipsAddr::label(label))); }
 
-static void emit_branch(int l, ostream& s)
-{
-  s << BRANCH;
-  emit_label_ref(l,s);
-  s << endl;
-}
+static void emit_bgti(char *src1, int imm, int label, MipsCode& s)
+{ s.add(MipsInsn(MIPS_BGT, -1, mips_reg(src1), -1, imm, MipsAddr::label(label))); }
+
+static void emit_branch(int l, MipsCode& s)
+{ s.add(MipsInsn(MIPS_B, -1, -1, -1, 0, MipsAddr::label(l))); }
 
 //
 // Push a register on the stack. The stack grows towards smaller addresses.
 //
-static void emit_push(char *reg, ostream& str)
+static void emit_push(char *reg, MipsCode& str)
 {
   emit_store(reg,0,SP,str);
   emit_addiu(SP,SP,-4,str);
@@ -327,31 +321,31 @@ static void emit_push(char *reg, ostream& str)
 // Emits code to fetch the integer value of the Integer object pointed
 // to by register source into the register dest
 //
-static void emit_fetch_int(char *dest, char *source, ostream& s)
+static void emit_fetch_int(char *dest, char *source, MipsCode& s)
 { emit_load(dest, DEFAULT_OBJFIELDS, source, s); }
 
 //
 // Emits code to store the integer value contained in register source
 // into the Integer object pointed to by dest.
 //
-static void emit_store_int(char *source, char *dest, ostream& s)
+static void emit_store_int(char *source, char *dest, MipsCode& s)
 { emit_store(source, DEFAULT_OBJFIELDS, dest, s); }
 
 
-static void emit_test_collector(ostream &s)
+static void emit_test_collector(MipsCode &s)
 {
   emit_push(ACC, s);
   emit_move(ACC, SP, s); // stack end
   emit_move(A1, ZERO, s); // allocate nothing
-  s << JAL << gc_collect_names[cgen_Memmgr] << endl;
+  emit_jal(gc_collect_names[cgen_Memmgr], s);
   emit_addiu(SP,SP,4,s);
   emit_load(ACC,0,SP,s);
 }
 
-static void emit_gc_check(char *source, ostream &s)
+static void emit_gc_check(char *source, MipsCode &s)
 {
   if (source != (char*)A1) emit_move(A1, source, s);
-  s << JAL << "_gc_check" << endl;
+  emit_jal("_gc_check", s);
 }
 
 
@@ -381,12 +375,11 @@ static void emit_gc_check(char *source, ostream &s)
 //
 void StringEntry::code_ref(ostream& s)
 {
-  s << STRCONST_PREFIX << index;
+  s << STRCONST_PREFIX << fast_int(index);
 }
 
 //
 // Emit code for a constant String.
-// You should fill in the code naming the dispatch table.
 //
 
 void StringEntry::code_def(ostream& s, int stringclasstag)
@@ -394,18 +387,14 @@ void StringEntry::code_def(ostream& s, int stringclasstag)
   IntEntryP lensym = inttable.add_int(len);
 
   // Add -1 eye catcher
-  s << WORD << "-1" << endl;
+  s << WORD << "-1\n";
 
   code_ref(s);  s  << LABEL                                             // label
-      << WORD << stringclasstag << endl                                 // tag
-      << WORD << (DEFAULT_OBJFIELDS + STRING_SLOTS + (len+4)/4) << endl // size
+      << WORD << fast_int(stringclasstag) << "\n"                               // tag
+      << WORD << fast_int(DEFAULT_OBJFIELDS + STRING_SLOTS + (len+4)/4) << "\n" // size
       << WORD;
-
-
- /***** Add dispatch information for class String ******/
-
-      s << endl;                                              // dispatch table
-      s << WORD;  lensym->code_ref(s);  s << endl;            // string length
+      emit_disptable_ref(Str, s);  s << "\n";                 // dispatch table
+      s << WORD;  lensym->code_ref(s);  s << "\n";            // string length
   emit_string_constant(s,str);                                // ascii string
   s << ALIGN;                                                 // align to word
 }
@@ -426,28 +415,24 @@ void StrTable::code_string_table(ostream& s, int stringclasstag)
 //
 void IntEntry::code_ref(ostream &s)
 {
-  s << INTCONST_PREFIX << index;
+  s << INTCONST_PREFIX << fast_int(index);
 }
 
 //
 // Emit code for a constant Integer.
-// You should fill in the code naming the dispatch table.
 //
 
 void IntEntry::code_def(ostream &s, int intclasstag)
 {
   // Add -1 eye catcher
-  s << WORD << "-1" << endl;
+  s << WORD << "-1\n";
 
   code_ref(s);  s << LABEL                                // label
-      << WORD << intclasstag << endl                      // class tag
-      << WORD << (DEFAULT_OBJFIELDS + INT_SLOTS) << endl  // object size
-      << WORD; 
-
- /***** Add dispatch information for class Int ******/
-
-      s << endl;                                          // dispatch table
-      s << WORD << str << endl;                           // integer value
+      << WORD << fast_int(intclasstag) << "\n"                    // class tag
+      << WORD << fast_int(DEFAULT_OBJFIELDS + INT_SLOTS) << "\n"  // object size
+      << WORD;
+      emit_disptable_ref(Int, s);  s << "\n";             // dispatch table
+      s << WORD << str << "\n";                           // integer value
 }
 
 
@@ -475,23 +460,19 @@ void BoolConst::code_ref(ostream& s) const
   
 //
 // Emit code for a constant Bool.
-// You should fill in the code naming the dispatch table.
 //
 
 void BoolConst::code_def(ostream& s, int boolclasstag)
 {
   // Add -1 eye catcher
-  s << WORD << "-1" << endl;
+  s << WORD << "-1\n";
 
   code_ref(s);  s << LABEL                                  // label
-      << WORD << boolclasstag << endl                       // class tag
-      << WORD << (DEFAULT_OBJFIELDS + BOOL_SLOTS) << endl   // object size
+      << WORD << boolclasstag << "\n"                       // class tag
+      << WORD << (DEFAULT_OBJFIELDS + BOOL_SLOTS) << "\n"   // object size
       << WORD;
-
- /***** Add dispatch information for class Bool ******/
-
-      s << endl;                                            // dispatch table
-      s << WORD << val << endl;                             // value (0 or 1)
+      emit_disptable_ref(Bool, s);  s << "\n";              // dispatch table
+      s << WORD << val << "\n";                             // value (0 or 1)
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -518,26 +499,26 @@ void CgenClassTable::code_global_data()
   //
   // The following global names must be defined first.
   //
-  str << GLOBAL << CLASSNAMETAB << endl;
-  str << GLOBAL; emit_protobj_ref(main,str);    str << endl;
-  str << GLOBAL; emit_protobj_ref(integer,str); str << endl;
-  str << GLOBAL; emit_protobj_ref(string,str);  str << endl;
-  str << GLOBAL; falsebool.code_ref(str);  str << endl;
-  str << GLOBAL; truebool.code_ref(str);   str << endl;
-  str << GLOBAL << INTTAG << endl;
-  str << GLOBAL << BOOLTAG << endl;
-  str << GLOBAL << STRINGTAG << endl;
+  str << GLOBAL << CLASSNAMETAB << "\n";
+  str << GLOBAL; emit_protobj_ref(main,str);    str << "\n";
+  str << GLOBAL; emit_protobj_ref(integer,str); str << "\n";
+  str << GLOBAL; emit_protobj_ref(string,str);  str << "\n";
+  str << GLOBAL; falsebool.code_ref(str);  str << "\n";
+  str << GLOBAL; truebool.code_ref(str);   str << "\n";
+  str << GLOBAL << INTTAG << "\n";
+  str << GLOBAL << BOOLTAG << "\n";
+  str << GLOBAL << STRINGTAG << "\n";
 
   //
   // We also need to know the tag of the Int, String, and Bool classes
   // during code generation.
   //
   str << INTTAG << LABEL
-      << WORD << intclasstag << endl;
+      << WORD << intclasstag << "\n";
   str << BOOLTAG << LABEL 
-      << WORD << boolclasstag << endl;
+      << WORD << boolclasstag << "\n";
   str << STRINGTAG << LABEL 
-      << WORD << stringclasstag << endl;    
+      << WORD << stringclasstag << "\n";    
 }
 
 
@@ -550,21 +531,21 @@ void CgenClassTable::code_global_data()
 
 void CgenClassTable::code_global_text()
 {
-  str << GLOBAL << HEAP_START << endl
+  str << GLOBAL << HEAP_START << "\n"
       << HEAP_START << LABEL 
-      << WORD << 0 << endl
-      << "\t.text" << endl
+      << WORD << 0 << "\n"
+      << "\t.text\n"
       << GLOBAL;
   emit_init_ref(idtable.add_string("Main"), str);
-  str << endl << GLOBAL;
+  str << "\n" << GLOBAL;
   emit_init_ref(idtable.add_string("Int"),str);
-  str << endl << GLOBAL;
+  str << "\n" << GLOBAL;
   emit_init_ref(idtable.add_string("String"),str);
-  str << endl << GLOBAL;
+  str << "\n" << GLOBAL;
   emit_init_ref(idtable.add_string("Bool"),str);
-  str << endl << GLOBAL;
+  str << "\n" << GLOBAL;
   emit_method_ref(idtable.add_string("Main"), idtable.add_string("main"), str);
-  str << endl;
+  str << "\n";
 }
 
 void CgenClassTable::code_bools(int boolclasstag)
@@ -578,15 +559,15 @@ void CgenClassTable::code_select_gc()
   //
   // Generate GC choice constants (pointers to GC functions)
   //
-  str << GLOBAL << "_MemMgr_INITIALIZER" << endl;
-  str << "_MemMgr_INITIALIZER:" << endl;
-  str << WORD << gc_init_names[cgen_Memmgr] << endl;
-  str << GLOBAL << "_MemMgr_COLLECTOR" << endl;
-  str << "_MemMgr_COLLECTOR:" << endl;
-  str << WORD << gc_collect_names[cgen_Memmgr] << endl;
-  str << GLOBAL << "_MemMgr_TEST" << endl;
-  str << "_MemMgr_TEST:" << endl;
-  str << WORD << (cgen_Memmgr_Test == GC_TEST) << endl;
+  str << GLOBAL << "_MemMgr_INITIALIZER\n";
+  str << "_MemMgr_INITIALIZER:\n";
+  str << WORD << gc_init_names[cgen_Memmgr] << "\n";
+  str << GLOBAL << "_MemMgr_COLLECTOR\n";
+  str << "_MemMgr_COLLECTOR:\n";
+  str << WORD << gc_collect_names[cgen_Memmgr] << "\n";
+  str << GLOBAL << "_MemMgr_TEST\n";
+  str << "_MemMgr_TEST:\n";
+  str << WORD << (cgen_Memmgr_Test == GC_TEST) << "\n";
 }
 
 
@@ -619,21 +600,22 @@ void CgenClassTable::code_constants()
 
 CgenClassTable::CgenClassTable(Classes classes, ostream& s) : nds(NULL) , str(s)
 {
-   stringclasstag = 0 /* Change to your String class tag here */;
-   intclasstag =    0 /* Change to your Int class tag here */;
-   boolclasstag =   0 /* Change to your Bool class tag here */;
-
    enterscope();
-   if (cgen_debug) cout << "Building CgenClassTable" << endl;
-   install_basic_classes();
-   install_classes(classes);
-   build_inheritance_tree();
+   if (cgen_debug) cerr << "Building CgenClassTable" << endl;
+   std::vector<Class_> sources;
+   install_basic_classes(sources);
+   for(int i = classes->first(); classes->more(i); i = classes->next(i))
+     sources.push_back(classes->nth(i));
+   if (class_hierarchy == NULL)
+     class_hierarchy = build_hierarchy(sources);
+   install_hierarchy(sources);
 
-   code();
-   exitscope();
+   stringclasstag = class_hierarchy->lookup(Str);
+   intclasstag =    class_hierarchy->lookup(Int);
+   boolclasstag =   class_hierarchy->lookup(Bool);
 }
 
-void CgenClassTable::install_basic_classes()
+void CgenClassTable::install_basic_classes(std::vector<Class_>& basic)
 {
 
 // The tree package uses these globals to annotate the classes built below.
@@ -667,8 +649,7 @@ void CgenClassTable::install_basic_classes()
 // There is no need for method bodies in the basic classes---these
 // are already built in to the runtime system.
 //
-  install_class(
-   new CgenNode(
+  basic.push_back(
     class_(Object, 
 	   No_class,
 	   append_Features(
@@ -676,8 +657,7 @@ void CgenClassTable::install_basic_classes()
            single_Features(method(cool_abort, nil_Formals(), Object, no_expr())),
            single_Features(method(type_name, nil_Formals(), Str, no_expr()))),
            single_Features(method(copy, nil_Formals(), SELF_TYPE, no_expr()))),
-	   filename),
-    Basic,this));
+	   filename));
 
 // 
 // The IO class inherits from Object. Its methods are
@@ -686,9 +666,8 @@ void CgenClassTable::install_basic_classes()
 //        in_string() : Str                    reads a string from the input
 //        in_int() : Int                         "   an int     "  "     "
 //
-   install_class(
-    new CgenNode(
-     class_(IO, 
+   basic.push_back(
+    class_(IO, 
             Object,
             append_Features(
             append_Features(
@@ -699,28 +678,23 @@ void CgenClassTable::install_basic_classes()
                         SELF_TYPE, no_expr()))),
             single_Features(method(in_string, nil_Formals(), Str, no_expr()))),
             single_Features(method(in_int, nil_Formals(), Int, no_expr()))),
-	   filename),	    
-    Basic,this));
+	   filename));
 
 //
 // The Int class has no methods and only a single attribute, the
 // "val" for the integer. 
 //
-   install_class(
-    new CgenNode(
-     class_(Int, 
+   basic.push_back(
+    class_(Int, 
 	    Object,
             single_Features(attr(val, prim_slot, no_expr())),
-	    filename),
-     Basic,this));
+	    filename));
 
 //
 // Bool also has only the "val" slot.
 //
-    install_class(
-     new CgenNode(
-      class_(Bool, Object, single_Features(attr(val, prim_slot, no_expr())),filename),
-      Basic,this));
+    basic.push_back(
+    class_(Bool, Object, single_Features(attr(val, prim_slot, no_expr())),filename));
 
 //
 // The class Str has a number of slots and operations:
@@ -730,9 +704,8 @@ void CgenClassTable::install_basic_classes()
 //       concat(arg: Str) : Str               string concatenation
 //       substr(arg: Int, arg2: Int): Str     substring
 //       
-   install_class(
-    new CgenNode(
-      class_(Str, 
+   basic.push_back(
+    class_(Str, 
 	     Object,
              append_Features(
              append_Features(
@@ -750,57 +723,78 @@ void CgenClassTable::install_basic_classes()
 						  single_Formals(formal(arg2, Int))),
 				   Str, 
 				   no_expr()))),
-	     filename),
-        Basic,this));
+	     filename));
 
 }
 
-// CgenClassTable::install_class
-// CgenClassTable::install_classes
 //
-// install_classes enters a list of classes in the symbol table.
-//
-void CgenClassTable::install_class(CgenNodeP nd)
-{
-  Symbol name = nd->get_name();
-
-  if (probe(name))
-    {
-      return;
-    }
-
-  // The class name is legal, so add it to the list of classes
-  // and the symbol table.
-  nds = new List<CgenNode>(nd,nds);
-  addid(name,nd);
-}
-
-void CgenClassTable::install_classes(Classes cs)
-{
-  for(int i = cs->first(); cs->more(i); i = cs->next(i))
-    install_class(new CgenNode(cs->nth(i),NotBasic,this));
-}
-
+// CgenClassTable::build_hierarchy
 //
-// CgenClassTable::build_inheritance_tree
+// Without a hierarchy from semant, build one from the classes: the five
+// basic classes followed by the program's, in declaration order.
 //
-void CgenClassTable::build_inheritance_tree()
+ClassHierarchy *CgenClassTable::build_hierarchy(std::vector<Class_>& sources)
 {
-  for(List<CgenNode> *l = nds; l; l = l->tl())
-      set_relations(l->hd());
+  ClassHierarchy *h = new ClassHierarchy;
+
+  for (size_t i = 0; i < sources.size(); i++) {
+    class__class *c = (class__class *) sources[i];
+    int hc = h->add_class(c->name, c->parent, i < BASIC_CLASSES);
+    Features fs = c->features;
+    for (int j = fs->first(); fs->more(j); j = fs->next(j)) {
+      Feature f = fs->nth(j);
+      if (attr_class *a = dynamic_cast<attr_class *>(f)) {
+        h->add_attr(hc, a->name, a->type_decl);
+      } else if (method_class *m = dynamic_cast<method_class *>(f)) {
+        std::vector<Symbol> formals;
+        for (int k = m->formals->first(); m->formals->more(k); k = m->formals->next(k))
+          formals.push_back(((formal_class *) m->formals->nth(k))->type_decl);
+        h->add_method(hc, m->name, m->return_type, formals);
+      }
+    }
+  }
+  if (!h->build()) {
+    cerr << "The classes do not form an inheritance tree.\n";
+    exit(1);
+  }
+  return h;
 }
 
 //
-// CgenClassTable::set_relations
+// CgenClassTable::install_hierarchy
 //
-// Takes a CgenNode and locates its, and its parent's, inheritance nodes
-// via the class table.  Parent and child pointers are added as appropriate.
+// Creates one CgenNode per class of the hierarchy, in tag order, and
+// links parents and children by index.  `sources' supplies the class
+// trees the nodes copy.
 //
-void CgenClassTable::set_relations(CgenNodeP nd)
+void CgenClassTable::install_hierarchy(std::vector<Class_>& sources)
 {
-  CgenNode *parent_node = probe(nd->get_parent());
-  nd->set_parentnd(parent_node);
-  parent_node->add_child(nd);
+  std::unordered_map<Symbol, Class_> by_name;
+  for (size_t i = 0; i < sources.size(); i++)
+    by_name[sources[i]->get_name()] = sources[i];
+
+  ClassHierarchy& h = *class_hierarchy;
+  int n = h.size();
+  nodes.resize(n);
+  for (int i = 0; i < n; i++) {
+    std::unordered_map<Symbol, Class_>::iterator it = by_name.find(h[i].name);
+    if (it == by_name.end()) {
+      cerr << "Class " << h[i].name << " is in the hierarchy but not in the program.\n";
+      exit(1);
+    }
+    nodes[i] = new CgenNode(it->second, h[i].basic ? Basic : NotBasic, this);
+    nodes[i]->set_hierarchy(i, &h[i]);
+    addid(h[i].name, nodes[i]);
+  }
+
+  for (int i = n - 1; i >= 0; i--) {
+    nds = new List<CgenNode>(nodes[i], nds);
+    HierClass& hc = h[i];
+    if (hc.parent_index >= 0)
+      nodes[i]->set_parentnd(nodes[hc.parent_index]);
+    for (int k = hc.children.size() - 1; k >= 0; k--)
+      nodes[i]->add_child(nodes[hc.children[k]]);
+  }
 }
 
 void CgenNode::add_child(CgenNodeP n)
@@ -817,37 +811,100 @@ void CgenNode::set_parentnd(CgenNodeP p)
 
 
 
+//
+// Prototype objects: the object `new' copies, with every attribute at
+// its default, void or the Int, Bool or String zero.
+//
+void CgenClassTable::code_prototypes()
+{
+  ClassHierarchy& h = *class_hierarchy;
+  for (int t = 0; t < h.size(); t++) {
+    std::vector<std::pair<int, HierFeature *> > layout;
+    h.attr_layout(t, layout);
+
+    str << WORD << "-1\n";
+    emit_protobj_ref(h[t].name, str);  str << LABEL
+        << WORD << t << "\n"
+        << WORD << (DEFAULT_OBJFIELDS + layout.size()) << "\n"
+        << WORD;  emit_disptable_ref(h[t].name, str);  str << "\n";
+    for (size_t i = 0; i < layout.size(); i++) {
+      Symbol type = layout[i].second->type;
+      str << WORD;
+      if (type == Int)
+        inttable.lookup_string("0")->code_ref(str);
+      else if (type == Bool)
+        falsebool.code_ref(str);
+      else if (type == Str)
+        stringtable.lookup_string("")->code_ref(str);
+      else
+        str << EMPTYSLOT;
+      str << "\n";
+    }
+  }
+}
+
+//
+// class_nameTab holds the name of every class and class_objTab its
+// prototype object and initializer, both indexed by tag.
+//
+void CgenClassTable::code_class_tables()
+{
+  ClassHierarchy& h = *class_hierarchy;
+  str << CLASSNAMETAB << LABEL;
+  for (int t = 0; t < h.size(); t++) {
+    str << WORD;
+    stringtable.lookup_string(h[t].name->get_string())->code_ref(str);
+    str << "\n";
+  }
+  str << CLASSOBJTAB << LABEL;
+  for (int t = 0; t < h.size(); t++) {
+    str << WORD;  emit_protobj_ref(h[t].name, str);  str << "\n";
+    str << WORD;  emit_init_ref(h[t].name, str);     str << "\n";
+  }
+}
+
+void CgenClassTable::code_dispatch_tables()
+{
+  ClassHierarchy& h = *class_hierarchy;
+  for (int t = 0; t < h.size(); t++) {
+    emit_disptable_ref(h[t].name, str);  str << LABEL;
+    for (int s = 0; s < h[t].method_count; s++) {
+      HierMethodRef r = h.dispatch(t, s);
+      str << WORD;  emit_method_ref(h[r.cls].name, r.method->name, str);  str << "\n";
+    }
+  }
+}
+
 void CgenClassTable::code()
 {
-  if (cgen_debug) cout << "coding global data" << endl;
+  if (cgen_debug) cerr << "lowering methods" << endl;
+  lower_functions();
+
+  if (cgen_debug) cerr << "coding global data" << endl;
   code_global_data();
 
-  if (cgen_debug) cout << "choosing gc" << endl;
+  if (cgen_debug) cerr << "choosing gc" << endl;
   code_select_gc();
 
-  if (cgen_debug) cout << "coding constants" << endl;
+  if (cgen_debug) cerr << "coding constants" << endl;
   code_constants();
 
-//                 Add your code to emit
-//                   - prototype objects
-//                   - class_nameTab
-//                   - dispatch tables
-//
+  if (cgen_debug) cerr << "coding class tables" << endl;
+  code_class_tables();
+  code_dispatch_tables();
+  code_prototypes();
 
-  if (cgen_debug) cout << "coding global text" << endl;
+  if (cgen_debug) cerr << "coding global text" << endl;
   code_global_text();
 
-//                 Add your code to emit
-//                   - object initializer
-//                   - the class methods
-//                   - etc...
-
+  if (cgen_debug) cerr << "coding methods" << endl;
+  code_functions();
 }
 
 
 CgenNodeP CgenClassTable::root()
 {
-   return probe(Object);
+   return nodes[0];
 }
 
 
@@ -861,101 +918,944 @@ CgenNode::CgenNode(Class_ nd, Basicness bstatus, CgenClassTableP ct) :
    class__class((const class__class &) *nd),
    parentnd(NULL),
    children(NULL),
-   basic_status(bstatus)
+   basic_status(bstatus),
+   tag(-1),
+   info(NULL)
 { 
    stringtable.add_string(name->get_string());          // Add class name to string table
 }
 
 
-//******************************************************************
+///////////////////////////////////////////////////////////////////////
 //
-//   Fill in the following methods to produce code for the
-//   appropriate expression.  You may add or remove parameters
-//   as you wish, but if you do, remember to change the parameters
-//   of the declarations in `cool-tree.h'  Sample code for
-//   constant integers, strings, and booleans are provided.
+// Lowering
 //
-//*****************************************************************
+// Every class gets an initializer, the basic ones included, since the
+// runtime calls Int_init, String_init and Bool_init itself.  Methods
+// of the basic classes are in the runtime.
+//
+///////////////////////////////////////////////////////////////////////
 
-void assign_class::code(ostream &s) {
+static bool is_empty(Expression e)
+{
+  return dynamic_cast<no_expr_class *>(e) != NULL;
 }
 
-void static_dispatch_class::code(ostream &s) {
+//
+// Constants and variables are the only expressions known not to
+// assign a variable.
+//
+static bool has_no_effect(Expression e)
+{
+  return dynamic_cast<object_class *>(e) || dynamic_cast<int_const_class *>(e)
+    || dynamic_cast<bool_const_class *>(e) || dynamic_cast<string_const_class *>(e);
 }
 
-void dispatch_class::code(ostream &s) {
+static int dispatches, devirtualized;         // for the -O -c report
+
+void CgenClassTable::lower_functions()
+{
+  stringtable.add_string("");
+  inttable.add_string("0");
+
+  ClassHierarchy& h = *class_hierarchy;
+  for (int t = 0; t < h.size(); t++) {
+    CgenNodeP c = nodes[t];
+
+    IrFunction *init = new IrFunction(std::string(c->get_name()->get_string()) + CLASSINIT_SUFFIX,
+                                      c->get_name(), c->get_filename(), 0);
+    IrBuilder b(init, c);
+    if (c->get_parentnd())
+      b.emit(IR_INIT, -1, b.self).cls = c->get_parentnd()->get_name();
+    Features fs = c->features;
+    for (int i = fs->first(); fs->more(i); i = fs->next(i)) {
+      attr_class *a = dynamic_cast<attr_class *>(fs->nth(i));
+      if (a == NULL || is_empty(a->init)) continue;
+      int v = a->init->code(b);
+      b.emit(IR_SETATTR, -1, b.self, v).imm = b.attribute(a->name);
+    }
+    b.ret(b.self);
+    functions.push_back(init);
+
+    if (c->basic()) continue;
+    for (int i = fs->first(); fs->more(i); i = fs->next(i)) {
+      method_class *m = dynamic_cast<method_class *>(fs->nth(i));
+      if (m == NULL) continue;
+      IrFunction *f = new IrFunction(std::string(c->get_name()->get_string()) + METHOD_SEP
+                                     + m->name->get_string(),
+                                     c->get_name(), c->get_filename(), m->formals->len());
+      IrBuilder b(f, c);
+      for (int k = m->formals->first(); m->formals->more(k); k = m->formals->next(k)) {
+        int r = b.variable();
+        b.emit(IR_PARAM, r).imm = k + 1;
+        b.bind(((formal_class *) m->formals->nth(k))->name, r);
+      }
+      b.ret(m->expr->code(b));
+      functions.push_back(f);
+    }
+  }
+
+  if (cgen_optimize) inline_calls(functions, cgen_debug);
+  for (size_t i = 0; i < functions.size(); i++) {
+    functions[i]->build_cfg();
+    if (cgen_optimize) optimize(*functions[i]);
+  }
+  if (cgen_debug && cgen_optimize)
+    cerr << devirtualized << " of " << dispatches << " dispatches devirtualized" << endl;
+  if (cgen_optimize) stack_allocate(functions, h, cgen_debug);
+  if (cgen_debug)
+    for (size_t i = 0; i < functions.size(); i++) functions[i]->dump(cerr);
+}
+
+IrBuilder::IrBuilder(IrFunction *f, CgenNodeP c) :
+  fn(f), cls(c), h(*class_hierarchy), block(0), line(c->get_line_number())
+{
+  std::vector<std::pair<int, HierFeature *> > layout;
+  h.attr_layout(c->get_tag(), layout);
+  for (size_t i = 0; i < layout.size(); i++)
+    attr_index[layout[i].second->name] = i;
+
+  start(new_block());
+  self = reg();
+  emit(IR_PARAM, self).imm = 0;
 }
 
-void cond_class::code(ostream &s) {
+int IrBuilder::new_block()
+{
+  fn->blocks.push_back(IrBlock());
+  return fn->blocks.size() - 1;
 }
 
-void loop_class::code(ostream &s) {
+IrInsn& IrBuilder::emit(IrOp op, int d, int a, int b)
+{
+  std::vector<IrInsn>& insns = fn->blocks[block].insns;
+  insns.push_back(IrInsn(op, d, a, b));
+  insns.back().line = line;
+  return insns.back();
 }
 
-void typcase_class::code(ostream &s) {
+void IrBuilder::jump(int target)
+{
+  emit(IR_JMP);
+  fn->blocks[block].succs.push_back(target);
 }
 
-void block_class::code(ostream &s) {
+void IrBuilder::branch(int v, int t, int f)
+{
+  emit(IR_BR, -1, v);
+  fn->blocks[block].succs.push_back(t);
+  fn->blocks[block].succs.push_back(f);
 }
 
-void let_class::code(ostream &s) {
+void IrBuilder::branch_range(int v, int lo, int hi, int t, int f)
+{
+  IrInsn& in = emit(IR_BRRANGE, -1, v);
+  in.imm = lo;
+  in.imm2 = hi;
+  fn->blocks[block].succs.push_back(t);
+  fn->blocks[block].succs.push_back(f);
 }
 
-void plus_class::code(ostream &s) {
+void IrBuilder::ret(int v)
+{
+  emit(IR_RET, -1, v);
 }
 
-void sub_class::code(ostream &s) {
+int IrBuilder::tag_of(Symbol type)
+{
+  return type == SELF_TYPE ? cls->get_tag() : h.lookup(type);
 }
 
-void mul_class::code(ostream &s) {
+int IrBuilder::local(Symbol name)
+{
+  for (int i = locals.size() - 1; i >= 0; i--)
+    if (locals[i].first == name) return locals[i].second;
+  return -1;
 }
 
-void divide_class::code(ostream &s) {
+int IrBuilder::hold(int r)
+{
+  if (!var[r]) return r;
+  int t = reg();
+  emit(IR_MOVE, t, r);
+  return t;
 }
 
-void neg_class::code(ostream &s) {
+int IrBuilder::default_value(Symbol type)
+{
+  int d = reg();
+  if (type == Int)
+    emit(IR_INT, d).sym = inttable.lookup_string("0");
+  else if (type == Bool)
+    emit(IR_BOOL, d).imm = FALSE;
+  else if (type == Str)
+    emit(IR_STR, d).sym = stringtable.lookup_string("");
+  else
+    emit(IR_VOID, d);
+  return d;
 }
 
-void lt_class::code(ostream &s) {
+
+///////////////////////////////////////////////////////////////////////
+//
+// Writing functions
+//
+// FunctionCoder writes one IrFunction, with its registers where the
+// Allocation (regalloc.h) put them.  Self is always in $s0.  A formal
+// left in the frame stays where the caller pushed it; any other
+// register left in the frame gets a word of its own:
+//
+//      formal 0                  fp + 4 * (top + 2 + formals)
+//      ...
+//      formal n-1                fp + 4 * (top + 3)
+//      saved $fp                 fp + 4 * (top + 2)
+//      saved $s0
+//      saved $ra                 fp + 4 * top
+//      saved $s1-$s6 it uses
+//      objects STACKNEW makes    each after its eyecatcher
+//      register slots            fp ...
+//      arguments being pushed    sp ...
+//
+// The callee pops its arguments.  The collector scans the stack for
+// pointers, so with -g the slots, objects' included, are cleared on
+// entry; they would otherwise hold whatever earlier frames left there.
+//
+///////////////////////////////////////////////////////////////////////
+
+static int label_count = 0;
+
+//
+// The words of an object of class `cls', eyecatcher not counted.
+//
+static int object_words(Symbol cls)
+{
+  return DEFAULT_OBJFIELDS + (*class_hierarchy)[class_hierarchy->lookup(cls)].attr_count;
+}
+
+class FunctionCoder {
+private:
+  IrFunction& f;
+  Allocation& alloc;
+  MipsCode& s;
+  std::vector<int> home;                     // fp offset by register, in words
+  std::vector<int> param;                    // formal number by register, or -1
+  std::vector<bool> number;                  // see IrFunction::numbers
+  std::vector<int> number_slots;             // frame words holding numbers
+  std::map<IrInsn *, int> object_slot;       // of a STACKNEW's eyecatcher
+  int slots;
+  int first_label;                           // of block 0
+
+  int top() { return slots + alloc.saved.size(); }
+  int frame_words() { return top() + 3; }
+  int block_label(int b) { return first_label + b; }
+  char *reg_of(int r) { return alloc.reg[r] >= 0 ? (char *) mips_reg_names[alloc.reg[r]] : NULL; }
+
+  char *load(int r, char *scratch);
+  void load_into(int r, char *reg);
+  char *target(int r, char *scratch);
+  void store(int r, char *reg);
+  void new_int(IrInsn& in);
+  void compare(IrInsn& in);
+  void void_check(char *abort, int line);
+  void clear_numbers();
+  void box(IrInsn& in);
+  void call(IrInsn& in);
+  void insn(IrInsn& in, int b);
+  void prologue();
+  void epilogue();
+public:
+  FunctionCoder(IrFunction& fn, Allocation& a, MipsCode& code);
+  void code();
+};
+
+FunctionCoder::FunctionCoder(IrFunction& fn, Allocation& a, MipsCode& code) :
+  f(fn), alloc(a), s(code), home(fn.nregs, -1), param(fn.nregs, -1), slots(0)
+{
+  for (size_t b = 0; b < f.blocks.size(); b++)
+    for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+      IrInsn& in = f.blocks[b].insns[i];
+      if (in.op == IR_PARAM) param[in.dst] = in.imm;
+    }
+  for (int r = 0; r < f.nregs; r++)
+    if (param[r] < 0 && alloc.reg[r] == REG_FRAME)
+      home[r] = slots++;
+  for (size_t b = 0; b < f.blocks.size(); b++)
+    for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+      IrInsn& in = f.blocks[b].insns[i];
+      if (in.op != IR_STACKNEW) continue;
+      object_slot[&in] = slots;
+      slots += 1 + object_words(in.cls);
+    }
+  for (int r = 0; r < f.nregs; r++)
+    if (param[r] > 0)
+      home[r] = top() + 2 + f.nformals - (param[r] - 1);
+  f.numbers(number);
+  for (int r = 0; r < f.nregs; r++)
+    if (number[r] && home[r] >= 0 && cgen_Memmgr != GC_NOGC)
+      number_slots.push_back(home[r]);
+  first_label = label_count;
+  label_count += f.blocks.size();
 }
 
-void eq_class::code(ostream &s) {
+//
+// The machine register holding `r': its own, or `scratch' with `r'
+// loaded into it.
+//
+char *FunctionCoder::load(int r, char *scratch)
+{
+  if (param[r] == 0) return SELF;
+  if (char *reg = reg_of(r)) return reg;
+  emit_load(scratch, home[r], FP, s);
+  return scratch;
 }
 
-void leq_class::code(ostream &s) {
+void FunctionCoder::load_into(int r, char *reg)
+{
+  char *src = load(r, reg);
+  if (src != reg) emit_move(reg, src, s);
 }
 
-void comp_class::code(ostream &s) {
+//
+// The machine register to compute `r' in: its own, or `scratch' if
+// `r' lives in the frame, in which case store() writes it back.
+//
+char *FunctionCoder::target(int r, char *scratch)
+{
+  char *reg = reg_of(r);
+  return reg ? reg : scratch;
 }
 
-void int_const_class::code(ostream& s)  
+void FunctionCoder::store(int r, char *reg)
 {
-  //
-  // Need to be sure we have an IntEntry *, not an arbitrary Symbol
-  //
-  emit_load_int(ACC,inttable.lookup_string(token->get_string()),s);
+  if (alloc.reg[r] == REG_UNUSED) return;
+  if (char *own = reg_of(r)) {
+    if (own != reg) emit_move(own, reg, s);
+  } else
+    emit_store(reg, home[r], FP, s);
 }
 
-void string_const_class::code(ostream& s)
+void FunctionCoder::prologue()
 {
-  emit_load_string(ACC,stringtable.lookup_string(token->get_string()),s);
+  int words = frame_words();
+  emit_addiu(SP, SP, -words * WORD_SIZE, s);
+  emit_store(FP, words, SP, s);
+  emit_store(SELF, words - 1, SP, s);
+  emit_store(RA, words - 2, SP, s);
+  for (size_t i = 0; i < alloc.saved.size(); i++)
+    emit_store((char *) mips_reg_names[alloc.saved[i]], slots + i + 1, SP, s);
+  emit_addiu(FP, SP, WORD_SIZE, s);
+  emit_move(SELF, ACC, s);
+  if (cgen_Memmgr != GC_NOGC)
+    for (int i = 0; i < slots; i++)
+      emit_store(ZERO, i, FP, s);
+}
+
+void FunctionCoder::epilogue()
+{
+  int words = frame_words();
+  emit_load(FP, words, SP, s);
+  emit_load(SELF, words - 1, SP, s);
+  emit_load(RA, words - 2, SP, s);
+  for (size_t i = 0; i < alloc.saved.size(); i++)
+    emit_load((char *) mips_reg_names[alloc.saved[i]], slots + i + 1, SP, s);
+  emit_addiu(SP, SP, (words + f.nformals) * WORD_SIZE, s);
+  emit_return(s);
 }
 
-void bool_const_class::code(ostream& s)
+//
+// Arithmetic allocates its result before it reads its operands, so no
+// raw integer is in a register or on the stack when the collector may
+// run.
+//
+void FunctionCoder::new_int(IrInsn& in)
 {
-  emit_load_bool(ACC, BoolConst(val), s);
+  emit_load_address(ACC, MipsAddr::protobj(Int), s);
+  emit_jal("Object.copy", s);
+  emit_fetch_int(T1, load(in.a, T1), s);
+  if (in.b >= 0) emit_fetch_int(T2, load(in.b, T2), s);
+  switch (in.op) {
+  case IR_ADD: emit_add(T1, T1, T2, s); break;
+  case IR_SUB: emit_sub(T1, T1, T2, s); break;
+  case IR_MUL: emit_mul(T1, T1, T2, s); break;
+  case IR_DIV: emit_div(T1, T1, T2, s); break;
+  case IR_NEG: emit_neg(T1, T1, s); break;
+  default: assert(0);
+  }
+  emit_store_int(T1, ACC, s);
+  store(in.dst, ACC);
+}
+
+//
+// Comparisons pick one of the two Bool constants.
+//
+void FunctionCoder::compare(IrInsn& in)
+{
+  int done = label_count++;
+  if (in.op == IR_EQUAL) {
+    load_into(in.a, T1);
+    load_into(in.b, T2);
+    emit_load_bool(ACC, truebool, s);
+    emit_beq(T1, T2, done, s);
+    emit_load_bool(A1, falsebool, s);
+    emit_jal("equality_test", s);
+    emit_label_def(done, s);
+    store(in.dst, ACC);
+    return;
+  }
+
+  char *d = target(in.dst, ACC);
+  if (in.op == IR_ISVOID) {
+    char *v = load(in.a, T1);
+    if (v == d) {
+      emit_move(T1, v, s);
+      v = T1;
+    }
+    emit_load_bool(d, truebool, s);
+    emit_beqz(v, done, s);
+  } else if (in.op == IR_NOT) {
+    emit_fetch_int(T1, load(in.a, T1), s);
+    emit_load_bool(d, truebool, s);
+    emit_beqz(T1, done, s);
+  } else {
+    emit_fetch_int(T1, load(in.a, T1), s);
+    emit_fetch_int(T2, load(in.b, T2), s);
+    emit_load_bool(d, truebool, s);
+    switch (in.op) {
+    case IR_LT: emit_blt(T1, T2, done, s); break;
+    case IR_LE: emit_bleq(T1, T2, done, s); break;
+    case IR_EQ: emit_beq(T1, T2, done, s); break;
+    default: assert(0);
+    }
+  }
+  emit_load_bool(d, falsebool, s);
+  emit_label_def(done, s);
+  store(in.dst, d);
 }
 
-void new__class::code(ostream &s) {
+//
+// Aborts with the file and line if $a0 is void.
+//
+void FunctionCoder::void_check(char *abort, int line)
+{
+  int ok = label_count++;
+  emit_bne(ACC, ZERO, ok, s);
+  emit_load_string(ACC, stringtable.lookup_string(f.file->get_string()), s);
+  emit_load_imm(T1, line, s);
+  emit_jal(abort, s);
+  emit_label_def(ok, s);
 }
 
-void isvoid_class::code(ostream &s) {
+//
+// No number is live where the collector may run, but one the frame
+// held earlier would still be there for it to take for a pointer.
+//
+void FunctionCoder::clear_numbers()
+{
+  for (size_t i = 0; i < number_slots.size(); i++)
+    emit_store(ZERO, number_slots[i], FP, s);
+}
+
+//
+// Object.copy leaves $a3 alone, and the collector never looks at it.
+//
+void FunctionCoder::box(IrInsn& in)
+{
+  load_into(in.a, A3);
+  clear_numbers();
+  emit_load_address(ACC, MipsAddr::protobj(Int), s);
+  emit_jal("Object.copy", s);
+  emit_store_int(A3, ACC, s);
+  store(in.dst, ACC);
 }
 
-void no_expr_class::code(ostream &s) {
+void FunctionCoder::call(IrInsn& in)
+{
+  for (size_t i = 0; i < in.args.size(); i++)
+    emit_push(load(in.args[i], ACC), s);
+  load_into(in.a, ACC);
+  if (!in.nonvoid) void_check("_dispatch_abort", in.line);
+  if (in.op == IR_CALL) {
+    emit_load(T1, DISPTABLE_OFFSET, ACC, s);
+    emit_load(T1, in.imm, T1, s);
+    emit_jalr(T1, s);
+  } else {
+    emit_jal(MipsAddr::method(in.cls, in.sym), s);
+  }
+  store(in.dst, ACC);
+}
+
+void FunctionCoder::insn(IrInsn& in, int b)
+{
+  std::vector<int>& succs = f.blocks[b].succs;
+  char *d = in.dst >= 0 ? target(in.dst, T1) : NULL;
+  char *v;
+
+  if (calls_out(in) && in.op != IR_BOX) clear_numbers();
+  switch (in.op) {
+  case IR_PARAM:
+    if (in.imm > 0 && reg_of(in.dst)) emit_load(d, home[in.dst], FP, s);
+    break;
+  case IR_INT:
+    emit_load_int(d, (IntEntry *) in.sym, s);
+    store(in.dst, d);
+    break;
+  case IR_STR:
+    emit_load_string(d, (StringEntry *) in.sym, s);
+    store(in.dst, d);
+    break;
+  case IR_BOOL:
+    emit_load_bool(d, BoolConst(in.imm), s);
+    store(in.dst, d);
+    break;
+  case IR_VOID:
+    store(in.dst, ZERO);
+    break;
+  case IR_MOVE:
+    store(in.dst, load(in.a, T1));
+    break;
+  case IR_GETATTR:
+    emit_load(d, DEFAULT_OBJFIELDS + in.imm, load(in.a, T1), s);
+    store(in.dst, d);
+    break;
+  case IR_SETATTR:
+    v = load(in.a, T1);
+    emit_store(load(in.b, T2), DEFAULT_OBJFIELDS + in.imm, v, s);
+    if (cgen_Memmgr == GC_GENGC) {
+      emit_addiu(A1, v, (DEFAULT_OBJFIELDS + in.imm) * WORD_SIZE, s);
+      emit_gc_assign(s);
+    }
+    break;
+  case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_NEG:
+    new_int(in);
+    break;
+  case IR_LT: case IR_LE: case IR_EQ: case IR_EQUAL: case IR_NOT: case IR_ISVOID:
+    compare(in);
+    break;
+  case IR_NEW:
+    emit_load_address(ACC, MipsAddr::protobj(in.cls), s);
+    emit_jal("Object.copy", s);
+    emit_jal(MipsAddr::init(in.cls), s);
+    store(in.dst, ACC);
+    break;
+  case IR_STACKNEW: {
+    int at = object_slot[&in] + 1;
+    emit_load_address(T2, MipsAddr::protobj(in.cls), s);
+    for (int w = -1; w < object_words(in.cls); w++) {
+      emit_load(T1, w, T2, s);
+      emit_store(T1, at + w, FP, s);
+    }
+    emit_addiu(ACC, FP, at * WORD_SIZE, s);
+    emit_jal(MipsAddr::init(in.cls), s);
+    store(in.dst, ACC);
+    break;
+  }
+  case IR_NEWSELF:
+    // The prototype and initializer are at 8 * tag in class_objTab.
+    emit_load_address(T1, MipsAddr::named(CLASSOBJTAB), s);
+    emit_load(T2, TAG_OFFSET, load(in.a, T2), s);
+    emit_sll(T2, T2, LOG_WORD_SIZE + 1, s);
+    emit_addu(T1, T1, T2, s);
+    emit_load(ACC, 0, T1, s);
+    emit_jal("Object.copy", s);
+    emit_load_address(T1, MipsAddr::named(CLASSOBJTAB), s);
+    emit_load(T2, TAG_OFFSET, ACC, s);
+    emit_sll(T2, T2, LOG_WORD_SIZE + 1, s);
+    emit_addu(T1, T1, T2, s);
+    emit_load(T1, 1, T1, s);
+    emit_jalr(T1, s);
+    store(in.dst, ACC);
+    break;
+  case IR_INIT:
+    load_into(in.a, ACC);
+    emit_jal(MipsAddr::init(in.cls), s);
+    break;
+  case IR_CALL: case IR_SCALL:
+    call(in);
+    break;
+  case IR_CHECK:
+    if (in.nonvoid) break;
+    load_into(in.a, ACC);
+    void_check("_dispatch_abort", in.line);
+    break;
+  case IR_TAG:
+    load_into(in.a, ACC);
+    if (!in.nonvoid) void_check("_case_abort2", in.line);
+    emit_load(d, TAG_OFFSET, ACC, s);
+    store(in.dst, d);
+    break;
+  case IR_UNBOX:
+    emit_fetch_int(d, load(in.a, T1), s);
+    store(in.dst, d);
+    break;
+  case IR_BOX:
+    box(in);
+    break;
+  case IR_BOXBOOL: {
+    int done = label_count++;
+    d = target(in.dst, ACC);
+    v = load(in.a, T1);
+    if (v == d) {
+      emit_move(T1, v, s);
+      v = T1;
+    }
+    emit_load_bool(d, truebool, s);
+    emit_bne(v, ZERO, done, s);
+    emit_load_bool(d, falsebool, s);
+    emit_label_def(done, s);
+    store(in.dst, d);
+    break;
+  }
+  case IR_IMM:
+    emit_load_imm(d, in.imm, s);
+    store(in.dst, d);
+    break;
+  case IR_RADD: case IR_RSUB: case IR_RMUL: case IR_RDIV:
+  case IR_RLT: case IR_RLE: case IR_REQ:
+    v = load(in.a, T1);
+    switch (in.op) {
+    case IR_RADD: emit_add(d, v, load(in.b, T2), s); break;
+    case IR_RSUB: emit_sub(d, v, load(in.b, T2), s); break;
+    case IR_RMUL: emit_mul(d, v, load(in.b, T2), s); break;
+    case IR_RDIV: emit_div(d, v, load(in.b, T2), s); break;
+    case IR_RLT: emit_slt(d, v, load(in.b, T2), s); break;
+    case IR_RLE: emit_sle(d, v, load(in.b, T2), s); break;
+    default: emit_seq(d, v, load(in.b, T2), s); break;
+    }
+    store(in.dst, d);
+    break;
+  case IR_RNEG:
+    emit_neg(d, load(in.a, T1), s);
+    store(in.dst, d);
+    break;
+  case IR_RNOT:
+    emit_xori(d, load(in.a, T1), 1, s);
+    store(in.dst, d);
+    break;
+  case IR_JMP:
+    if (succs[0] != b + 1) emit_branch(block_label(succs[0]), s);
+    break;
+  case IR_BR:
+    if (number[in.a])
+      v = load(in.a, T1);
+    else {
+      emit_fetch_int(T1, load(in.a, T1), s);
+      v = T1;
+    }
+    if (succs[0] == b + 1)
+      emit_beqz(v, block_label(succs[1]), s);
+    else {
+      emit_bne(v, ZERO, block_label(succs[0]), s);
+      if (succs[1] != b + 1) emit_branch(block_label(succs[1]), s);
+    }
+    break;
+  case IR_BRRANGE:
+    v = load(in.a, T1);
+    emit_blti(v, in.imm, block_label(succs[1]), s);
+    emit_bgti(v, in.imm2, block_label(succs[1]), s);
+    if (succs[0] != b + 1) emit_branch(block_label(succs[0]), s);
+    break;
+  case IR_RET:
+    load_into(in.a, ACC);
+    epilogue();
+    break;
+  case IR_CASEABORT:
+    load_into(in.a, ACC);
+    emit_jal("_case_abort", s);
+    break;
+  default:
+    assert(0);
+  }
+}
+
+void FunctionCoder::code()
+{
+  s.add(MipsInsn(MIPS_LABEL, -1, -1, -1, 0, MipsAddr::named(f.name.c_str())));
+  prologue();
+  for (size_t b = 0; b < f.blocks.size(); b++) {
+    if (!f.blocks[b].preds.empty())
+      emit_label_def(block_label(b), s);
+    for (size_t i = 0; i < f.blocks[b].insns.size(); i++)
+      insn(f.blocks[b].insns[i], b);
+  }
 }
 
-void object_class::code(ostream &s) {
+//
+// With -r every register lives in the frame.
+//
+void CgenClassTable::code_functions()
+{
+  int removed = 0;
+  for (size_t i = 0; i < functions.size(); i++) {
+    Allocation a;
+    if (disable_reg_alloc)
+      allocate_frame(*functions[i], a);
+    else
+      allocate_registers(*functions[i], a);
+    MipsCode code;
+    FunctionCoder(*functions[i], a, code).code();
+    if (cgen_optimize) removed += peephole(code);
+    code.print(str);
+  }
+  if (cgen_debug && cgen_optimize)
+    cerr << removed << " instructions removed by peephole" << endl;
 }
 
 
+//******************************************************************
+//
+//   Expression::code lowers an expression into the current block of
+//   the IrBuilder, adding blocks as control flow needs them, and
+//   returns the register holding its value.
+//
+//*****************************************************************
+
+int assign_class::code(IrBuilder &b)
+{
+  int v = expr->code(b);
+  int r = b.local(name);
+  if (r >= 0) {
+    b.emit(IR_MOVE, r, v);
+    return r;
+  }
+  b.emit(IR_SETATTR, -1, b.self, v).imm = b.attribute(name);
+  return v;
+}
+
+//
+// Arguments are evaluated left to right, then the receiver.  Under -O
+// a dispatch that can only reach one method calls it directly.
+//
+static int code_call(IrBuilder &b, IrOp op, Expression recv, Expressions actual,
+                     Symbol name, Symbol type, int line)
+{
+  std::vector<Expression> later;
+  for (int i = actual->first(); actual->more(i); i = actual->next(i))
+    later.push_back(actual->nth(i));
+  later.push_back(recv);
+
+  std::vector<int> args;
+  for (size_t i = 0; i + 1 < later.size(); i++) {
+    int r = later[i]->code(b);
+    for (size_t k = i + 1; k < later.size(); k++)
+      if (!has_no_effect(later[k])) {
+        r = b.hold(r);
+        break;
+      }
+    args.push_back(r);
+  }
+  int self = recv->code(b);
+
+  int t = b.tag_of(type);
+  int d = b.reg();
+  b.line = line;
+  IrInsn& in = b.emit(op, d, self);
+  in.args = args;
+  in.sym = name;
+  in.imm = b.h.find_slot(t, name);
+  if (op == IR_CALL) {
+    dispatches++;
+    std::vector<HierMethodRef> impls;
+    if (cgen_optimize) b.h.implementations(t, in.imm, impls);
+    if (impls.size() == 1) {
+      in.op = IR_SCALL;
+      devirtualized++;
+    }
+  }
+  if (in.op == IR_SCALL)
+    in.cls = b.h[b.h.dispatch(t, in.imm).cls].name;
+  return d;
+}
+
+int static_dispatch_class::code(IrBuilder &b)
+{
+  return code_call(b, IR_SCALL, expr, actual, name, type_name, get_line_number());
+}
+
+int dispatch_class::code(IrBuilder &b)
+{
+  return code_call(b, IR_CALL, expr, actual, name, expr->get_type(), get_line_number());
+}
+
+int cond_class::code(IrBuilder &b)
+{
+  int p = pred->code(b);
+  int r = b.reg();
+  int t = b.new_block(), f = b.new_block(), join = b.new_block();
+  b.branch(p, t, f);
+  b.start(t);
+  b.emit(IR_MOVE, r, then_exp->code(b));
+  b.jump(join);
+  b.start(f);
+  b.emit(IR_MOVE, r, else_exp->code(b));
+  b.jump(join);
+  b.start(join);
+  return r;
+}
+
+int loop_class::code(IrBuilder &b)
+{
+  int test = b.new_block(), loop = b.new_block(), done = b.new_block();
+  b.jump(test);
+  b.start(test);
+  b.branch(pred->code(b), loop, done);
+  b.start(loop);
+  body->code(b);
+  b.jump(test);
+  b.start(done);
+  int r = b.reg();
+  b.emit(IR_VOID, r);
+  return r;
+}
+
+//
+// Branches are tried from the deepest class up, so the first whose
+// subtree holds the value's tag is the closest ancestor.
+//
+int typcase_class::code(IrBuilder &b)
+{
+  int v = expr->code(b);
+  int tag = b.reg();
+  b.line = get_line_number();
+  b.emit(IR_TAG, tag, v);
+
+  std::vector<branch_class *> branches;
+  for (int i = cases->first(); cases->more(i); i = cases->next(i))
+    branches.push_back((branch_class *) cases->nth(i));
+  for (size_t i = 1; i < branches.size(); i++)
+    for (size_t k = i; k > 0 && b.h[b.tag_of(branches[k]->type_decl)].depth >
+                                b.h[b.tag_of(branches[k - 1]->type_decl)].depth; k--)
+      std::swap(branches[k], branches[k - 1]);
+
+  int r = b.reg();
+  int join = b.new_block();
+  for (size_t i = 0; i < branches.size(); i++) {
+    int t = b.tag_of(branches[i]->type_decl);
+    int match = b.new_block(), next = b.new_block();
+    b.branch_range(tag, t, b.h[t].last, match, next);
+    b.start(match);
+    int var = b.variable();
+    b.emit(IR_MOVE, var, v);
+    b.bind(branches[i]->name, var);
+    b.emit(IR_MOVE, r, branches[i]->expr->code(b));
+    b.unbind();
+    b.jump(join);
+    b.start(next);
+  }
+  b.emit(IR_CASEABORT, -1, v);
+  b.start(join);
+  return r;
+}
+
+int block_class::code(IrBuilder &b)
+{
+  int r = -1;
+  for (int i = body->first(); body->more(i); i = body->next(i))
+    r = body->nth(i)->code(b);
+  return r;
+}
+
+int let_class::code(IrBuilder &b)
+{
+  int v = is_empty(init) ? b.default_value(type_decl) : init->code(b);
+  int var = b.variable();
+  b.emit(IR_MOVE, var, v);
+  b.bind(identifier, var);
+  int r = body->code(b);
+  b.unbind();
+  return r;
+}
+
+static int code_binary(IrBuilder &b, IrOp op, Expression e1, Expression e2)
+{
+  int x = e1->code(b);
+  if (!has_no_effect(e2)) x = b.hold(x);
+  int y = e2->code(b);
+  int d = b.reg();
+  b.emit(op, d, x, y);
+  return d;
+}
+
+static int code_unary(IrBuilder &b, IrOp op, Expression e1)
+{
+  int x = e1->code(b);
+  int d = b.reg();
+  b.emit(op, d, x);
+  return d;
+}
+
+int plus_class::code(IrBuilder &b)   { return code_binary(b, IR_ADD, e1, e2); }
+int sub_class::code(IrBuilder &b)    { return code_binary(b, IR_SUB, e1, e2); }
+int mul_class::code(IrBuilder &b)    { return code_binary(b, IR_MUL, e1, e2); }
+int divide_class::code(IrBuilder &b) { return code_binary(b, IR_DIV, e1, e2); }
+int lt_class::code(IrBuilder &b)     { return code_binary(b, IR_LT, e1, e2); }
+int leq_class::code(IrBuilder &b)    { return code_binary(b, IR_LE, e1, e2); }
+int neg_class::code(IrBuilder &b)    { return code_unary(b, IR_NEG, e1); }
+int comp_class::code(IrBuilder &b)   { return code_unary(b, IR_NOT, e1); }
+int isvoid_class::code(IrBuilder &b) { return code_unary(b, IR_ISVOID, e1); }
+
+//
+// Ints and Bools compare by value; anything else goes through the
+// runtime's equality_test.
+//
+int eq_class::code(IrBuilder &b)
+{
+  Symbol t = e1->get_type();
+  return code_binary(b, t == Int || t == Bool ? IR_EQ : IR_EQUAL, e1, e2);
+}
+
+int int_const_class::code(IrBuilder &b)
+{
+  //
+  // Need to be sure we have an IntEntry *, not an arbitrary Symbol
+  //
+  int d = b.reg();
+  b.emit(IR_INT, d).sym = inttable.lookup_string(token->get_string());
+  return d;
+}
+
+int string_const_class::code(IrBuilder &b)
+{
+  int d = b.reg();
+  b.emit(IR_STR, d).sym = stringtable.lookup_string(token->get_string());
+  return d;
+}
+
+int bool_const_class::code(IrBuilder &b)
+{
+  int d = b.reg();
+  b.emit(IR_BOOL, d).imm = val ? TRUE : FALSE;
+  return d;
+}
+
+//
+// A new Int, Bool or String is the same as its default value.
+//
+int new__class::code(IrBuilder &b)
+{
+  if (type_name == Int || type_name == Bool || type_name == Str)
+    return b.default_value(type_name);
+  int d = b.reg();
+  b.line = get_line_number();
+  if (type_name == SELF_TYPE)
+    b.emit(IR_NEWSELF, d, b.self);
+  else
+    b.emit(IR_NEW, d).cls = type_name;
+  return d;
+}
+
+int no_expr_class::code(IrBuilder &b)
+{
+  int d = b.reg();
+  b.emit(IR_VOID, d);
+  return d;
+}
+
+int object_class::code(IrBuilder &b)
+{
+  if (name == self) return b.self;
+  int r = b.local(name);
+  if (r >= 0) return r;
+  int d = b.reg();
+  b.emit(IR_GETATTR, d, b.self).imm = b.attribute(name);
+  return d;
+}
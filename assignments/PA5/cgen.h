@@ -3,11 +3,18 @@
 #include "emit.h"
 #include "cool-tree.h"
 #include "symtab.h"
+#include "hierarchy.h"
+#include "ir.h"
+#include <vector>
+#include <unordered_map>
 
 enum Basicness     {Basic, NotBasic};
 #define TRUE 1
 #define FALSE 0
 
+// Object, IO, Int, Bool and String
+#define BASIC_CLASSES 5
+
 class CgenClassTable;
 typedef CgenClassTable *CgenClassTableP;
 
@@ -16,7 +23,8 @@ typedef CgenNode *CgenNodeP;
 
 class CgenClassTable : public SymbolTable<Symbol,CgenNode> {
 private:
-   List<CgenNode> *nds;
+   List<CgenNode> *nds;                       // in tag order
+   std::vector<CgenNodeP> nodes;              // indexed by tag
    ostream& str;
    int stringclasstag;
    int intclasstag;
@@ -32,22 +40,81 @@ private:
    void code_select_gc();
    void code_constants();
 
-// The following creates an inheritance graph from
-// a list of classes.  The graph is implemented as
-// a tree of `CgenNode', and class names are placed
-// in the base class symbol table.
+// The following creates the inheritance graph from the
+// class hierarchy, building that first if semant did not
+// hand one over.  The graph is implemented as a tree of
+// `CgenNode', and class names are placed in the base class
+// symbol table.
+
+   void install_basic_classes(std::vector<Class_>& basic);
+   ClassHierarchy *build_hierarchy(std::vector<Class_>& sources);
+   void install_hierarchy(std::vector<Class_>& sources);
 
-   void install_basic_classes();
-   void install_class(CgenNodeP nd);
-   void install_classes(Classes cs);
-   void build_inheritance_tree();
-   void set_relations(CgenNodeP nd);
+// Every method and initializer is lowered to an IrFunction before
+// anything is emitted, and the functions are written out after the
+// data segment.
+
+   std::vector<IrFunction *> functions;
+   void lower_functions();
+   void code_prototypes();
+   void code_class_tables();
+   void code_dispatch_tables();
+   void code_functions();
 public:
    CgenClassTable(Classes, ostream& str);
    void code();
    CgenNodeP root();
+   CgenNodeP node(int tag) { return nodes[tag]; }
 };
 
+extern ClassHierarchy *class_hierarchy;
+
+//
+// What Expression::code lowers a function with: the function and its
+// current block, the class it belongs to, and the variables in scope.
+// Every expression returns the register holding its value.  Locals and
+// formals are registers too; an expression evaluated while another's
+// value is held must not change that value, so a variable that the
+// rest of the evaluation could assign is copied with `hold' first.
+//
+class IrBuilder {
+private:
+   std::vector<std::pair<Symbol, int> > locals;
+   std::vector<bool> var;                     // by register
+   std::unordered_map<Symbol, int> attr_index;
+public:
+   IrFunction *fn;
+   CgenNodeP cls;
+   ClassHierarchy& h;
+   int self;                                  // register holding self
+   int block;                                 // block being added to
+   int line;                                  // line of what is emitted
+
+   IrBuilder(IrFunction *f, CgenNodeP c);
+
+   int reg() { var.push_back(false); return fn->new_reg(); }
+   int variable() { var.push_back(true); return fn->new_reg(); }
+   int new_block();
+   void start(int b) { block = b; }
+
+   IrInsn& emit(IrOp op, int d = -1, int a = -1, int b = -1);
+   void jump(int target);
+   void branch(int v, int t, int f);
+   void branch_range(int v, int lo, int hi, int t, int f);
+   void ret(int v);
+
+   int tag_of(Symbol type);
+   int attribute(Symbol name) { return attr_index[name]; }
+   int local(Symbol name);
+   void bind(Symbol name, int r) { locals.push_back(std::make_pair(name, r)); }
+   void unbind() { locals.pop_back(); }
+   int hold(int r);
+   int default_value(Symbol type);
+};
+
+// Lowers the program to bytecode and writes the image (bclower.cc).
+void bytecode_program(CgenClassTableP table, ostream& os);
+
 
 class CgenNode : public class__class {
 private: 
@@ -55,6 +122,8 @@ private:
    List<CgenNode> *children;                  // Children of class
    Basicness basic_status;                    // `Basic' if class is basic
                                               // `NotBasic' otherwise
+   int tag;                                   // class tag, -1 if special
+   HierClass *info;                           // features and layout
 
 public:
    CgenNode(Class_ c,
@@ -66,6 +135,9 @@ public:
    void set_parentnd(CgenNodeP p);
    CgenNodeP get_parentnd() { return parentnd; }
    int basic() { return (basic_status == Basic); }
+   void set_hierarchy(int t, HierClass *h) { tag = t; info = h; }
+   int get_tag() { return tag; }
+   HierClass *get_info() { return info; }
 };
 
 class BoolConst 
@@ -74,6 +146,7 @@ class BoolConst
   int val;
  public:
   BoolConst(int);
+  int get_val() const { return val; }
   void code_def(ostream&, int boolclasstag);
   void code_ref(ostream&) const;
 };
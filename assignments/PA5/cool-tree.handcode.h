@@ -44,14 +44,22 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+class BcLowering;
+class IrBuilder;
+class Folder;
+
 #define Program_EXTRAS                          \
 virtual void cgen(ostream&) = 0;		\
+virtual void bytecode(ostream&) = 0;		\
+virtual void fold() = 0;			\
 virtual void dump_with_types(ostream&, int) = 0; 
 
 
 
 #define program_EXTRAS                          \
 void cgen(ostream&);     			\
+void bytecode(ostream&);     			\
+void fold();     				\
 void dump_with_types(ostream&, int);            
 
 #define Class__EXTRAS                   \
@@ -96,13 +104,17 @@ void dump_with_types(ostream& ,int);
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
-virtual void code(ostream&) = 0; \
+virtual int code(IrBuilder&) = 0; \
+virtual void lower(BcLowering&, int) = 0; \
+virtual Expression fold(Folder&) = 0; \
 virtual void dump_with_types(ostream&,int) = 0;  \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 #define Expression_SHARED_EXTRAS           \
-void code(ostream&); 			   \
+int code(IrBuilder&); 			   \
+void lower(BcLowering&, int);		   \
+Expression fold(Folder&);		   \
 void dump_with_types(ostream&,int); 
 
 
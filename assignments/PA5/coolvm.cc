@@ -0,0 +1,663 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  coolvm.cc
+//
+//  The bytecode interpreter:  coolvm [-s] program.cvm < input
+//
+//  It runs a module cgen -b wrote the way spim runs the MIPS code with
+//  the runtime in trap.handler: the same output, the same messages for
+//  runtime errors, and "COOL program successfully executed" at the end.
+//  The NoGC runtime's "Increasing heap..." notes have no counterpart.
+//  With -s the number of instructions run and the rate are printed on
+//  stderr when main returns.
+//
+//  Values are machine words.  An Int is its value shifted up 32 bits
+//  with the low bit set, a Bool its value shifted up with bit 1 set,
+//  void is 0, and anything else points at an object: a header with the
+//  class tag and the number of attributes (or, for a String, the number
+//  of characters) followed by the attributes or the characters.  Ints
+//  and Bools are never boxed, and equal ones are the same word.
+//
+//  Objects are allocated in a semispace heap and collected by copying.
+//  The roots are the registers of all active frames, which live on one
+//  stack; string constants and class names are allocated outside the
+//  heap and never move.  A frame's registers are cleared when it is
+//  entered so the collector never sees a stale word.
+//
+//  Dispatch is threaded: every handler ends by jumping straight to the
+//  handler of the next instruction through a table of label addresses.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include "bytecode.h"
+
+typedef uintptr_t Value;
+
+struct Obj {
+   uint32_t cls;
+   uint32_t size;                 // attributes, or characters of a String
+};
+
+#define FORWARDED 0xffffffffu      // cls of an object the collector moved
+
+static inline Obj *obj(Value v) { return (Obj *) v; }
+static inline Value *slots(Obj *o) { return (Value *) (o + 1); }
+static inline char *chars(Obj *o) { return (char *) (o + 1); }
+
+static inline Value int_value(int32_t i) { return ((Value) (uint32_t) i << 32) | 1; }
+static inline int32_t int_of(Value v) { return (int32_t) (v >> 32); }
+static const Value FALSE_VALUE = 2;
+static const Value TRUE_VALUE = ((Value) 1 << 32) | 2;
+static inline bool is_pointer(Value v) { return v != 0 && (v & 3) == 0; }
+
+struct VmClass {
+   Obj *name;
+   Obj *proto;                    // a fresh object before initialization
+   int last;
+   int init;
+   const int *dispatch;
+};
+
+struct VmFunction {
+   const BcInsn *code;
+   const int *lines;
+   int nargs, nregs;
+   const char *name, *file;
+};
+
+struct Frame {
+   const BcInsn *ret;
+   Value *base;
+   VmFunction *fn;
+   int dst;
+};
+
+static BcModule module;
+static std::vector<VmClass> classes;
+static std::vector<VmFunction> functions;
+static std::vector<Obj *> constants;
+static int int_tag, bool_tag, string_tag;
+
+#define STACK_SLOTS (1 << 22)
+#define FRAMES (1 << 20)
+static Value *stack, *stack_end;
+static Value *stack_top;           // end of the registers in use
+static Frame *frames;
+
+static long long instructions;
+
+//////////////////////////////////////////////////////////////////////
+//
+// Messages and exits
+//
+//////////////////////////////////////////////////////////////////////
+
+[[noreturn]] static void halt()
+{
+   fflush(stdout);
+   exit(0);
+}
+
+[[noreturn]] static void exception(int code, const char *what)
+{
+   printf("  Exception %d  [%s]  Execution aborted\n", code, what);
+   halt();
+}
+
+static int line_of(VmFunction *fn, const BcInsn *ip)
+{
+   return fn->lines[ip - fn->code];
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// The heap
+//
+//////////////////////////////////////////////////////////////////////
+
+static char *heap, *heap_end, *heap_free;
+static size_t heap_size = 4 << 20;
+
+static size_t size_of(Obj *o)
+{
+   size_t n = o->cls == (uint32_t) string_tag ? (o->size + 7) & ~7 : o->size * sizeof(Value);
+   return sizeof(Obj) + (n < sizeof(Value) ? sizeof(Value) : n);
+}
+
+static char *to_free;
+
+static void forward(Value *p)
+{
+   Value v = *p;
+   if (!is_pointer(v) || (char *) v < heap || (char *) v >= heap_end) return;
+   Obj *o = obj(v);
+   if (o->cls != FORWARDED) {
+      size_t n = size_of(o);
+      memcpy(to_free, o, n);
+      o->cls = FORWARDED;
+      slots(o)[0] = (Value) to_free;
+      to_free += n;
+   }
+   *p = slots(o)[0];
+}
+
+//
+// Copy everything reachable from the stack into a new space of `size'
+// bytes.  Cheney's scan: the new space is the queue of objects whose
+// attributes are still to be forwarded.
+//
+static void copy_heap(size_t size)
+{
+   char *to = (char *) malloc(size);
+   if (to == NULL) {
+      fflush(stdout);
+      fprintf(stderr, "coolvm: out of memory\n");
+      exit(1);
+   }
+   to_free = to;
+   for (Value *p = stack; p < stack_top; p++) forward(p);
+   for (char *scan = to; scan < to_free; scan += size_of((Obj *) scan)) {
+      Obj *o = (Obj *) scan;
+      if (o->cls != (uint32_t) string_tag)
+         for (uint32_t i = 0; i < o->size; i++) forward(&slots(o)[i]);
+   }
+   free(heap);
+   heap = to;
+   heap_end = to + size;
+   heap_free = to_free;
+   heap_size = size;
+}
+
+static void collect(size_t need)
+{
+   copy_heap(heap_size);
+   size_t live = heap_free - heap;
+   if (live + need > heap_size / 2) {
+      size_t size = heap_size;
+      while (live + need > size / 2) size *= 2;
+      copy_heap(size);
+   }
+}
+
+static inline Obj *allocate(size_t n)
+{
+   if (n < sizeof(Obj) + sizeof(Value)) n = sizeof(Obj) + sizeof(Value);
+   n = (n + 7) & ~(size_t) 7;
+   if (heap_free + n > heap_end) collect(n);
+   Obj *o = (Obj *) heap_free;
+   heap_free += n;
+   return o;
+}
+
+static Obj *new_string(const char *s, size_t len)
+{
+   Obj *o = allocate(sizeof(Obj) + len);
+   o->cls = string_tag;
+   o->size = len;
+   memcpy(chars(o), s, len);
+   return o;
+}
+
+static Obj *static_string(const std::string& s)
+{
+   Obj *o = (Obj *) calloc(1, sizeof(Obj) + sizeof(Value) + s.size());
+   o->cls = string_tag;
+   o->size = s.size();
+   memcpy(chars(o), s.data(), s.size());
+   return o;
+}
+
+static inline int class_of(Value v)
+{
+   if (v & 1) return int_tag;
+   if (v & 2) return bool_tag;
+   return obj(v)->cls;
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// The methods of the basic classes.  `args' points at the receiver,
+// followed by the arguments; they are read again after allocating,
+// which may move them.
+//
+//////////////////////////////////////////////////////////////////////
+
+static std::string read_line()
+{
+   fflush(stdout);
+   std::string s;
+   int c;
+   while ((c = getchar()) != EOF) {
+      s += (char) c;
+      if (c == '\n') break;
+   }
+   return s;
+}
+
+#define MAX_STRING 1025            // what trap.handler reads at most
+
+static Value native(int id, Value *args)
+{
+   switch (id) {
+   case NATIVE_ABORT:
+      printf("Abort called from class ");
+      fwrite(chars(classes[class_of(args[0])].name), 1,
+             classes[class_of(args[0])].name->size, stdout);
+      printf("\n");
+      halt();
+   case NATIVE_TYPE_NAME:
+      return (Value) classes[class_of(args[0])].name;
+   case NATIVE_COPY: {
+      if (!is_pointer(args[0])) return args[0];
+      size_t n = size_of(obj(args[0]));
+      Obj *o = allocate(n);
+      memcpy(o, obj(args[0]), n);
+      return (Value) o;
+   }
+   case NATIVE_OUT_STRING:
+      fwrite(chars(obj(args[1])), 1, obj(args[1])->size, stdout);
+      return args[0];
+   case NATIVE_OUT_INT:
+      printf("%d", int_of(args[1]));
+      return args[0];
+   case NATIVE_IN_STRING: {
+      std::string s = read_line();
+      if (s.size() > MAX_STRING) s.resize(MAX_STRING);
+      if (s.empty())
+         s = "\n";                 // what the runtime returns at end of file
+      else if (s[s.size() - 1] == '\n')
+         s.resize(s.size() - 1);
+      return (Value) new_string(s.data(), s.size());
+   }
+   case NATIVE_IN_INT:
+      return int_value(atoi(read_line().c_str()));
+   case NATIVE_LENGTH:
+      return int_value(obj(args[0])->size);
+   case NATIVE_CONCAT: {
+      size_t n1 = obj(args[0])->size, n2 = obj(args[1])->size;
+      Obj *o = allocate(sizeof(Obj) + n1 + n2);
+      o->cls = string_tag;
+      o->size = n1 + n2;
+      memcpy(chars(o), chars(obj(args[0])), n1);
+      memcpy(chars(o) + n1, chars(obj(args[1])), n2);
+      return (Value) o;
+   }
+   case NATIVE_SUBSTR: {
+      int32_t len = obj(args[0])->size, i = int_of(args[1]), l = int_of(args[2]);
+      const char *error = NULL;
+      if (i < 0) error = "Index to substr is negative\n";
+      else if (i > len) error = "Index to substr is too big\n";
+      else if (l > len - i) error = "Length to substr too long\n";
+      else if (l < 0) error = "Length to substr is negative\n";
+      if (error) {
+         printf("%sExecution aborted.\n", error);
+         halt();
+      }
+      Obj *o = allocate(sizeof(Obj) + l);
+      o->cls = string_tag;
+      o->size = l;
+      memcpy(chars(o), chars(obj(args[0])) + i, l);
+      return (Value) o;
+   }
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// The interpreter
+//
+//////////////////////////////////////////////////////////////////////
+
+[[noreturn]] static void void_error(VmFunction *fn, const BcInsn *ip, const char *what)
+{
+   printf("%s:%d%s", fn->file, line_of(fn, ip), what);
+   halt();
+}
+
+[[noreturn]] static void stack_overflow()
+{
+   printf(" Stack overflow detected, COOL program aborted\n");
+   halt();
+}
+
+static void run()
+{
+   static void *labels[] = {
+#define BC_LABEL(op) &&op_##op,
+      BC_OPS(BC_LABEL)
+#undef BC_LABEL
+   };
+
+   VmFunction *fn = &functions[module.entry - NATIVES];
+   Value *R = stack;
+   const BcInsn *ip = fn->code;
+   Frame *fp = frames, *frames_end = frames + FRAMES;
+   long long count = 0;
+   stack_top = R + fn->nregs;
+
+#define DISPATCH() do { count++; goto *labels[ip->op]; } while (0)
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+
+//
+// Enter function `id' with its registers at `base', the result going
+// to R[dst].  Natives run on the spot.
+//
+#define ENTER(ID, BASE, DST) do {                                      \
+      int id_ = (ID);                                                 \
+      Value *base_ = (BASE);                                          \
+      if (id_ < NATIVES) {                                            \
+         Value v_ = native(id_, base_);                               \
+         R[DST] = v_;                                                 \
+         NEXT();                                                      \
+      }                                                               \
+      VmFunction *callee_ = &functions[id_ - NATIVES];                \
+      if (base_ + callee_->nregs > stack_end || fp == frames_end)     \
+         stack_overflow();                                            \
+      fp->ret = ip + 1;                                               \
+      fp->base = R;                                                   \
+      fp->fn = fn;                                                    \
+      fp->dst = (DST);                                                \
+      fp++;                                                           \
+      for (int i_ = callee_->nargs + 1; i_ < callee_->nregs; i_++)    \
+         base_[i_] = 0;                                               \
+      R = base_;                                                      \
+      fn = callee_;                                                   \
+      stack_top = R + fn->nregs;                                      \
+      ip = fn->code;                                                  \
+      DISPATCH();                                                     \
+   } while (0)
+
+   DISPATCH();
+
+op_MOVE:
+   R[ip->a] = R[ip->b];
+   NEXT();
+op_LOADI:
+   R[ip->a] = int_value(ip->imm());
+   NEXT();
+op_LOADB:
+   R[ip->a] = ip->b ? TRUE_VALUE : FALSE_VALUE;
+   NEXT();
+op_LOADS:
+   R[ip->a] = (Value) constants[ip->imm()];
+   NEXT();
+op_LOADV:
+   R[ip->a] = 0;
+   NEXT();
+op_GETATTR:
+   R[ip->a] = slots(obj(R[0]))[ip->b];
+   NEXT();
+op_SETATTR:
+   slots(obj(R[0]))[ip->a] = R[ip->b];
+   NEXT();
+op_ADD: {
+   int32_t r;
+   if (__builtin_add_overflow(int_of(R[ip->b]), int_of(R[ip->c]), &r))
+      exception(12, "Arithmetic overflow");
+   R[ip->a] = int_value(r);
+   NEXT();
+}
+op_SUB: {
+   int32_t r;
+   if (__builtin_sub_overflow(int_of(R[ip->b]), int_of(R[ip->c]), &r))
+      exception(12, "Arithmetic overflow");
+   R[ip->a] = int_value(r);
+   NEXT();
+}
+op_MUL:
+   R[ip->a] = int_value((int32_t) ((uint32_t) int_of(R[ip->b]) * (uint32_t) int_of(R[ip->c])));
+   NEXT();
+op_DIV: {
+   int32_t x = int_of(R[ip->b]), y = int_of(R[ip->c]);
+   if (y == 0) exception(9, "Breakpoint/Division by 0");
+   R[ip->a] = int_value(y == -1 ? (int32_t) (0u - (uint32_t) x) : x / y);
+   NEXT();
+}
+op_NEG: {
+   int32_t x = int_of(R[ip->b]);
+   if (x == INT32_MIN) exception(12, "Arithmetic overflow");
+   R[ip->a] = int_value(-x);
+   NEXT();
+}
+op_LT:
+   R[ip->a] = int_of(R[ip->b]) < int_of(R[ip->c]) ? TRUE_VALUE : FALSE_VALUE;
+   NEXT();
+op_LE:
+   R[ip->a] = int_of(R[ip->b]) <= int_of(R[ip->c]) ? TRUE_VALUE : FALSE_VALUE;
+   NEXT();
+op_EQ: {
+   Value x = R[ip->b], y = R[ip->c];
+   bool eq = x == y;
+   if (!eq && is_pointer(x) && is_pointer(y) && obj(x)->cls == (uint32_t) string_tag
+       && obj(y)->cls == (uint32_t) string_tag)
+      eq = obj(x)->size == obj(y)->size && memcmp(chars(obj(x)), chars(obj(y)), obj(x)->size) == 0;
+   R[ip->a] = eq ? TRUE_VALUE : FALSE_VALUE;
+   NEXT();
+}
+op_NOT:
+   R[ip->a] = R[ip->b] ^ (TRUE_VALUE ^ FALSE_VALUE);
+   NEXT();
+op_ISVOID:
+   R[ip->a] = R[ip->b] == 0 ? TRUE_VALUE : FALSE_VALUE;
+   NEXT();
+op_JMP:
+   ip = fn->code + ip->imm();
+   DISPATCH();
+op_JT:
+   if (R[ip->a] == TRUE_VALUE) {
+      ip = fn->code + ip->imm();
+      DISPATCH();
+   }
+   NEXT();
+op_JF:
+   if (R[ip->a] != TRUE_VALUE) {
+      ip = fn->code + ip->imm();
+      DISPATCH();
+   }
+   NEXT();
+op_NEWSELF:
+op_NEW: {
+   VmClass& k = classes[ip->op == OP_NEW ? ip->b : class_of(R[0])];
+   size_t n = size_of(k.proto);
+   Obj *o = allocate(n);
+   memcpy(o, k.proto, n);
+   if (k.init < 0) {
+      R[ip->a] = (Value) o;
+      NEXT();
+   }
+   Value *base = R + fn->nregs;
+   base[0] = (Value) o;
+   ENTER(k.init, base, ip->a);
+}
+op_CALL: {
+   Value self = R[ip->b];
+   if (self == 0) void_error(fn, ip, ": Dispatch to void.\n");
+   ENTER(classes[class_of(self)].dispatch[ip->c], R + ip->b, ip->a);
+}
+op_CALLS:
+   if (R[ip->b] == 0) void_error(fn, ip, ": Dispatch to void.\n");
+   ENTER(ip->c, R + ip->b, ip->a);
+op_RET: {
+   Value v = R[ip->a];
+   if (fp == frames) goto done;
+   fp--;
+   R = fp->base;
+   fn = fp->fn;
+   ip = fp->ret;
+   R[fp->dst] = v;
+   stack_top = R + fn->nregs;
+   DISPATCH();
+}
+op_TAG:
+   if (R[ip->b] == 0) void_error(fn, ip, "Match on void in case statement.\n");
+   R[ip->a] = int_value(class_of(R[ip->b]));
+   NEXT();
+op_INRANGE: {
+   int32_t t = int_of(R[ip->a]);
+   ip += ip->b <= t && t <= ip->c ? 2 : 1;
+   DISPATCH();
+}
+op_CASEABORT: {
+   Obj *name = classes[int_of(R[ip->a])].name;
+   printf("No match in case statement for Class ");
+   fwrite(chars(name), 1, name->size, stdout);
+   printf("\n");
+   halt();
+}
+
+done:
+   instructions = count;
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+// Loading
+//
+//////////////////////////////////////////////////////////////////////
+
+//
+// Whether an instruction's operands are in range, so the interpreter
+// need not check them.
+//
+static bool valid(const BcInsn& in, const BcFunction& fn, size_t pc,
+                  int nclasses, int nstrings, int nfunctions)
+{
+   int imm = in.imm();
+   if (in.op == OP_SETATTR) return in.b < fn.nregs;     // a is an attribute
+   if (in.op >= BC_OP_COUNT || in.a >= fn.nregs) return false;
+   switch (in.op) {
+   case OP_LOADI: case OP_LOADV: case OP_NEWSELF: case OP_RET: case OP_CASEABORT:
+   case OP_GETATTR:
+      return true;
+   case OP_LOADB:
+      return in.b <= 1;
+   case OP_LOADS:
+      return imm >= 0 && imm < nstrings;
+   case OP_JMP: case OP_JT: case OP_JF:
+      return imm >= 0 && imm < (int) fn.code.size();
+   case OP_NEW:
+      return in.b < nclasses;
+   case OP_INRANGE:
+      return pc + 1 < fn.code.size();
+   case OP_CALL:
+      return in.b < fn.nregs;
+   case OP_CALLS:
+      return in.b < fn.nregs && in.c < NATIVES + nfunctions;
+   default:
+      return in.b < fn.nregs && in.c < fn.nregs;
+   }
+}
+
+static bool load(const char *path)
+{
+   FILE *f = fopen(path, "rb");
+   if (f == NULL) {
+      fprintf(stderr, "coolvm: cannot open %s\n", path);
+      exit(1);
+   }
+   bool ok = module.read(f);
+   fclose(f);
+   if (!ok) return false;
+
+   int nstrings = module.strings.size();
+   int nclasses = module.classes.size();
+   int nfunctions = module.functions.size();
+   int_tag = module.int_tag;
+   bool_tag = module.bool_tag;
+   string_tag = module.string_tag;
+   if (string_tag < 0 || string_tag >= nclasses || int_tag < 0 || int_tag >= nclasses
+       || bool_tag < 0 || bool_tag >= nclasses
+       || module.entry < NATIVES || module.entry >= NATIVES + nfunctions)
+      return false;
+
+   for (int i = 0; i < nstrings; i++)
+      constants.push_back(static_string(module.strings[i]));
+
+   // Every operand is checked here once so the interpreter need not.
+   for (int i = 0; i < nclasses; i++) {
+      BcClass& c = module.classes[i];
+      if (c.name < 0 || c.name >= nstrings || c.init >= NATIVES + nfunctions)
+         return false;
+      for (size_t k = 0; k < c.dispatch.size(); k++)
+         if (c.dispatch[k] < 0 || c.dispatch[k] >= NATIVES + nfunctions) return false;
+      VmClass k;
+      k.name = constants[c.name];
+      k.last = c.last;
+      k.init = c.init;
+      k.dispatch = c.dispatch.data();
+      k.proto = (Obj *) calloc(1, sizeof(Obj) + (c.attrs.size() + 1) * sizeof(Value));
+      k.proto->cls = i;
+      k.proto->size = c.attrs.size();
+      for (size_t a = 0; a < c.attrs.size(); a++)
+         slots(k.proto)[a] = c.attrs[a] == DEFAULT_INT ? int_value(0)
+            : c.attrs[a] == DEFAULT_BOOL ? FALSE_VALUE
+            : c.attrs[a] == DEFAULT_STRING ? (Value) static_string("") : 0;
+      classes.push_back(k);
+   }
+
+   for (int i = 0; i < nfunctions; i++) {
+      BcFunction& bf = module.functions[i];
+      if (bf.name < 0 || bf.name >= nstrings || bf.file < 0 || bf.file >= nstrings
+          || bf.nargs < 0 || bf.nregs <= bf.nargs || bf.lines.size() != bf.code.size()
+          || bf.code.empty() || bf.code.back().op != OP_RET)
+         return false;
+      for (size_t pc = 0; pc < bf.code.size(); pc++)
+         if (!valid(bf.code[pc], bf, pc, nclasses, nstrings, nfunctions)) return false;
+      VmFunction fn;
+      fn.code = bf.code.data();
+      fn.lines = bf.lines.data();
+      fn.nargs = bf.nargs;
+      fn.nregs = bf.nregs;
+      fn.name = module.strings[bf.name].c_str();
+      fn.file = module.strings[bf.file].c_str();
+      functions.push_back(fn);
+   }
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   bool stats = false;
+   int c;
+   while ((c = getopt(argc, argv, "s")) != -1) {
+      if (c == 's')
+         stats = true;
+      else {
+         fprintf(stderr, "usage: %s [-s] program.cvm\n", argv[0]);
+         exit(1);
+      }
+   }
+   if (optind != argc - 1) {
+      fprintf(stderr, "usage: %s [-s] program.cvm\n", argv[0]);
+      exit(1);
+   }
+   if (!load(argv[optind])) {
+      fprintf(stderr, "coolvm: %s is not a valid bytecode image\n", argv[optind]);
+      exit(1);
+   }
+
+   stack = (Value *) calloc(STACK_SLOTS + 1, sizeof(Value));   // NEW's self may land at the end
+   stack_end = stack + STACK_SLOTS;
+   frames = (Frame *) malloc(FRAMES * sizeof(Frame));
+   heap = (char *) malloc(heap_size);
+   heap_end = heap + heap_size;
+   heap_free = heap;
+   static char out[1 << 16];
+   setvbuf(stdout, out, _IOFBF, sizeof out);
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   run();
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   printf("COOL program successfully executed\n");
+   fflush(stdout);
+   if (stats)
+      fprintf(stderr, "coolvm: %lld instructions in %.6f s, %.1f M/s\n",
+              instructions, seconds, instructions / seconds / 1e6);
+   return 0;
+}
@@ -0,0 +1,223 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  escape.cc
+//
+//  When an object escapes, for stack_allocate; see escape.h.  What a
+//  function does with an object is worked out from which registers may
+//  hold it, wherever in the function they are read, and from a summary
+//  of every method and initializer it may call:
+//
+//    captured[p]    parameter p (0 is self) may be kept somewhere that
+//                   outlives the call
+//    returned[p]    it may be what the call returns
+//
+//  An object escapes if it is stored in an attribute, returned, or
+//  passed to a call that may capture it; a call that may return it
+//  makes its result hold it too.  Anything else that reads it, other
+//  than getattr, setattr on it, =, isvoid, a void check, a case or new
+//  SELF_TYPE, counts as capturing it.  The summaries start with nothing captured
+//  or returned and grow until they hold.  A dispatch may reach every
+//  method its slot holds in any class; the runtime's methods capture
+//  nothing, and IO's out_string and out_int return self.
+//
+//  A NEW that runs again reuses the same words of the frame, so it is
+//  only moved there if nothing that may hold the object it made last
+//  time is live when it runs.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include "emit.h"
+#include "escape.h"
+
+struct Summary {
+   std::vector<bool> captured, returned;
+};
+
+class Escape {
+private:
+   std::vector<IrFunction *>& fns;
+   ClassHierarchy& h;
+   std::map<std::string, int> index;           // function by name
+   std::vector<Summary> sum;
+
+   void targets(const IrInsn& in, std::vector<std::string>& out);
+   bool captures(const std::string& fn, int p, bool& returned);
+   void flow(IrFunction& f, std::vector<bool>& holds, bool& captured, bool& returned);
+   void summarize();
+public:
+   Escape(std::vector<IrFunction *>& functions, ClassHierarchy& hier);
+   int run(bool report);
+};
+
+Escape::Escape(std::vector<IrFunction *>& functions, ClassHierarchy& hier) :
+   fns(functions), h(hier)
+{
+   for (size_t i = 0; i < fns.size(); i++) index[fns[i]->name] = i;
+}
+
+//
+// The functions a CALL, SCALL or INIT may run.
+//
+void Escape::targets(const IrInsn& in, std::vector<std::string>& out)
+{
+   out.clear();
+   if (in.op == IR_INIT) {
+      out.push_back(std::string(in.cls->get_string()) + CLASSINIT_SUFFIX);
+      return;
+   }
+   int first = 0, last = h.size() - 1;
+   if (in.op == IR_SCALL) first = last = h.lookup(in.cls);
+   for (int c = first; c <= last; c++) {
+      if (in.imm >= h[c].method_count) continue;
+      HierMethodRef m = h.dispatch(c, in.imm);
+      if (m.cls < 0 || m.method->name != in.sym) continue;
+      std::string name = std::string(h[m.cls].name->get_string()) + METHOD_SEP
+         + in.sym->get_string();
+      if (std::find(out.begin(), out.end(), name) == out.end()) out.push_back(name);
+   }
+}
+
+//
+// Whether `fn' may capture its parameter `p'; sets `returned' if it
+// may return it.
+//
+bool Escape::captures(const std::string& fn, int p, bool& returned)
+{
+   std::map<std::string, int>::iterator i = index.find(fn);
+   if (i == index.end()) {
+      if (p == 0 && (fn == "IO.out_string" || fn == "IO.out_int")) returned = true;
+      return false;
+   }
+   if (sum[i->second].returned[p]) returned = true;
+   return sum[i->second].captured[p];
+}
+
+//
+// Grows `holds', the registers that may hold the object, until it is
+// closed, and says whether `f' may capture or return the object.
+//
+void Escape::flow(IrFunction& f, std::vector<bool>& holds, bool& captured, bool& returned)
+{
+   captured = returned = false;
+   std::vector<std::string> callees;
+   std::vector<int> uses;
+   for (bool changed = true; changed && !captured; ) {
+      changed = false;
+      for (size_t b = 0; b < f.blocks.size(); b++)
+         for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+            IrInsn& in = f.blocks[b].insns[i];
+            bool to_dst = false;
+            switch (in.op) {
+            case IR_MOVE:
+               to_dst = holds[in.a];
+               break;
+            case IR_PHI:
+               for (size_t k = 0; k < in.args.size(); k++) to_dst = to_dst || holds[in.args[k]];
+               break;
+            case IR_GETATTR: case IR_EQUAL: case IR_ISVOID: case IR_CHECK: case IR_TAG:
+            case IR_NEWSELF:
+               break;
+            case IR_SETATTR:
+               if (holds[in.b]) captured = true;
+               break;
+            case IR_RET:
+               if (holds[in.a]) returned = true;
+               break;
+            case IR_CALL: case IR_SCALL: case IR_INIT:
+               targets(in, callees);
+               for (size_t p = 0; p <= in.args.size(); p++) {
+                  if (!holds[p == 0 ? in.a : in.args[p - 1]]) continue;
+                  if (callees.empty()) captured = true;
+                  for (size_t k = 0; k < callees.size(); k++)
+                     if (captures(callees[k], p, to_dst)) captured = true;
+               }
+               break;
+            default:
+               in.uses(uses);
+               for (size_t k = 0; k < uses.size(); k++)
+                  if (holds[uses[k]]) captured = true;
+               break;
+            }
+            if (to_dst && in.dst >= 0 && !holds[in.dst]) holds[in.dst] = changed = true;
+         }
+   }
+}
+
+void Escape::summarize()
+{
+   sum.assign(fns.size(), Summary());
+   for (size_t i = 0; i < fns.size(); i++) {
+      sum[i].captured.assign(fns[i]->nformals + 1, false);
+      sum[i].returned.assign(fns[i]->nformals + 1, false);
+   }
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (size_t i = 0; i < fns.size(); i++) {
+         IrFunction& f = *fns[i];
+         for (int p = 0; p <= f.nformals; p++) {
+            std::vector<bool> holds(f.nregs, false);
+            for (size_t b = 0; b < f.blocks.size(); b++)
+               for (size_t k = 0; k < f.blocks[b].insns.size(); k++) {
+                  IrInsn& in = f.blocks[b].insns[k];
+                  if (in.op == IR_PARAM && in.imm == p) holds[in.dst] = true;
+               }
+            bool captured, returned;
+            flow(f, holds, captured, returned);
+            if ((captured && !sum[i].captured[p]) || (returned && !sum[i].returned[p])) {
+               if (captured) sum[i].captured[p] = true;
+               if (returned) sum[i].returned[p] = true;
+               changed = true;
+            }
+         }
+      }
+   }
+}
+
+int Escape::run(bool report)
+{
+   summarize();
+   int moved = 0, sites = 0;
+   std::vector<std::vector<bool> > live_in, live_out;
+   std::vector<int> uses;
+   for (size_t n = 0; n < fns.size(); n++) {
+      IrFunction& f = *fns[n];
+      f.liveness(live_in, live_out);
+      for (size_t b = 0; b < f.blocks.size(); b++) {
+         std::vector<bool> live = live_out[b];
+         for (int i = f.blocks[b].insns.size() - 1; i >= 0; i--) {
+            IrInsn& in = f.blocks[b].insns[i];
+            if (in.dst >= 0) live[in.dst] = false;
+            in.uses(uses);
+            for (size_t k = 0; k < uses.size(); k++) live[uses[k]] = true;
+            if (in.op != IR_NEW) continue;
+
+            sites++;
+            std::vector<bool> holds(f.nregs, false);
+            holds[in.dst] = true;
+            bool captured, returned, self = false, again = false;
+            flow(f, holds, captured, returned);
+            if (captures(std::string(in.cls->get_string()) + CLASSINIT_SUFFIX, 0, self))
+               captured = true;
+            for (int r = 0; r < f.nregs; r++)
+               if (holds[r] && live[r]) again = true;
+            if (captured || returned || again) continue;
+
+            in.op = IR_STACKNEW;
+            moved++;
+            if (report)
+               cerr << f.name << ": new " << in.cls << " at line " << in.line
+                    << " is in the frame" << endl;
+         }
+      }
+   }
+   if (report) cerr << moved << " of " << sites << " news in the frame" << endl;
+   return moved;
+}
+
+int stack_allocate(std::vector<IrFunction *>& functions, ClassHierarchy& h, bool report)
+{
+   return Escape(functions, h).run(report);
+}
@@ -0,0 +1,30 @@
+#ifndef ESCAPE_H_
+#define ESCAPE_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  escape.h
+//
+//  With -O, an object that `new' makes and that cannot outlive the
+//  activation making it is put in that activation's frame instead of
+//  the heap: its NEW becomes a STACKNEW, and FunctionCoder copies the
+//  prototype, header and all, into words of the frame.  See escape.cc
+//  for when an object escapes.
+//
+//  The collector scans the frame as it scans any stack, so the
+//  object's attributes are roots and are updated when what they point
+//  to moves; the object itself is outside the heap, so a pointer to it
+//  is left alone.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "hierarchy.h"
+#include "ir.h"
+
+// Turns the NEWs of `functions' whose objects do not escape into
+// STACKNEWs and returns how many there were.  With `report' each is
+// listed on cerr.
+int stack_allocate(std::vector<IrFunction *>& functions, ClassHierarchy& h, bool report);
+
+#endif
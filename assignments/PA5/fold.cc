@@ -0,0 +1,405 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  fold.cc
+//
+//  Constant folding and algebraic simplification on the typed AST,
+//  which cgen -O runs after semant and before either backend.
+//
+//  Expression::fold folds its subexpressions and returns what should
+//  replace it: itself, a new constant, or one of its subexpressions.
+//  A replacement keeps the static type of what it replaces, since the
+//  parent's code may depend on it (how = compares, which class a
+//  dispatch looks the method up in).  Arithmetic that would overflow
+//  or divide by zero is left for the program to trap on at run time,
+//  and nothing with a side effect is dropped.  New constants go into
+//  inttable and stringtable like the ones the lexer made.
+//
+//  With -c every fold is reported on stderr.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "cool-tree.h"
+
+extern int cgen_debug;
+
+class Folder {
+public:
+   Symbol filename;
+   int folds;
+   Symbol concat, length, self, substr;
+
+   Folder() : filename(NULL), folds(0),
+      concat(idtable.add_string("concat")), length(idtable.add_string("length")),
+      self(idtable.add_string("self")), substr(idtable.add_string("substr")) { }
+
+   Expression folded(Expression from, Expression to, const std::string& what);
+   Expression int_result(Expression from, int n, const std::string& what);
+   Expression bool_result(Expression from, bool b, const std::string& what);
+   Expression string_result(Expression from, const std::string& s, const std::string& what);
+};
+
+Expression Folder::folded(Expression from, Expression to, const std::string& what)
+{
+   folds++;
+   if (cgen_debug)
+      cerr << filename << ":" << from->get_line_number() << ": " << what << endl;
+   return to->set_type(from->get_type());
+}
+
+Expression Folder::int_result(Expression from, int n, const std::string& what)
+{
+   Expression c = int_const(inttable.add_int(n));
+   c->set(from);
+   return folded(from, c, what + " folded to " + std::to_string(n));
+}
+
+Expression Folder::bool_result(Expression from, bool b, const std::string& what)
+{
+   Expression c = bool_const(b);
+   c->set(from);
+   return folded(from, c, what + " folded to " + (b ? "true" : "false"));
+}
+
+Expression Folder::string_result(Expression from, const std::string& s, const std::string& what)
+{
+   std::vector<char> buf(s.begin(), s.end());
+   buf.push_back('\0');
+   Expression c = string_const(stringtable.add_string(buf.data(), s.size()));
+   c->set(from);
+   return folded(from, c, what + " folded to a constant");
+}
+
+//
+// The value of an Int constant, unless it does not fit.
+//
+static bool int_value(Expression e, int& n)
+{
+   int_const_class *c = dynamic_cast<int_const_class *>(e);
+   if (c == NULL) return false;
+   long long v = strtoll(c->token->get_string(), NULL, 10);
+   if (v > INT_MAX) return false;
+   n = (int) v;
+   return true;
+}
+
+static bool bool_value(Expression e, bool& b)
+{
+   bool_const_class *c = dynamic_cast<bool_const_class *>(e);
+   if (c == NULL) return false;
+   b = c->val;
+   return true;
+}
+
+static bool string_value(Expression e, Symbol& s)
+{
+   string_const_class *c = dynamic_cast<string_const_class *>(e);
+   if (c == NULL) return false;
+   s = c->token;
+   return true;
+}
+
+static bool is_constant(Expression e)
+{
+   return dynamic_cast<int_const_class *>(e) || dynamic_cast<bool_const_class *>(e)
+      || dynamic_cast<string_const_class *>(e);
+}
+
+//
+// Whether evaluating e does nothing but produce its value.
+//
+static bool is_pure(Expression e)
+{
+   return is_constant(e) || dynamic_cast<object_class *>(e) || dynamic_cast<no_expr_class *>(e);
+}
+
+static bool same_variable(Expression x, Expression y)
+{
+   object_class *a = dynamic_cast<object_class *>(x), *b = dynamic_cast<object_class *>(y);
+   return a && b && a->name == b->name;
+}
+
+static Expressions fold_list(Expressions l, Folder& F)
+{
+   Expressions out = nil_Expressions();
+   bool changed = false;
+   for (int i = l->first(); l->more(i); i = l->next(i)) {
+      Expression e = l->nth(i), f = e->fold(F);
+      changed = changed || f != e;
+      out = append_Expressions(out, single_Expressions(f));
+   }
+   return changed ? out : l;
+}
+
+//
+// Int arithmetic on constants as the emitted code does it, when it
+// neither traps nor overflows; otherwise the identities that hold
+// whatever the other operand is.
+//
+static Expression arith(Folder& F, Expression e, char op, Expression e1, Expression e2)
+{
+   int x, y;
+   bool cx = int_value(e1, x), cy = int_value(e2, y);
+   std::string sop(1, op);
+   if (cx && cy) {
+      long long v;
+      switch (op) {
+      case '+': v = (long long) x + y; break;
+      case '-': v = (long long) x - y; break;
+      case '*': v = (long long) x * y; break;
+      default:
+         if (y == 0) return e;
+         v = (long long) x / y;
+         break;
+      }
+      if (v < INT_MIN || v > INT_MAX) return e;
+      return F.int_result(e, (int) v, std::to_string(x) + " " + sop + " " + std::to_string(y));
+   }
+   if (cy && y == 0 && (op == '+' || op == '-'))
+      return F.folded(e, e1, "e " + sop + " 0 simplified to e");
+   if (cy && y == 1 && (op == '*' || op == '/'))
+      return F.folded(e, e1, "e " + sop + " 1 simplified to e");
+   if (cx && x == 0 && op == '+')
+      return F.folded(e, e2, "0 + e simplified to e");
+   if (cx && x == 1 && op == '*')
+      return F.folded(e, e2, "1 * e simplified to e");
+   if (op == '*' && ((cx && x == 0 && is_pure(e2)) || (cy && y == 0 && is_pure(e1))))
+      return F.int_result(e, 0, "e * 0");
+   return e;
+}
+
+//
+// Comparisons of constants of the same kind, and of a variable with
+// itself.
+//
+static Expression compare(Folder& F, Expression e, const char *op, Expression e1, Expression e2)
+{
+   int x, y;
+   bool a, b;
+   Symbol s, t;
+   std::string sop(op);
+   if (int_value(e1, x) && int_value(e2, y)) {
+      bool r = sop == "<" ? x < y : sop == "<=" ? x <= y : x == y;
+      return F.bool_result(e, r, std::to_string(x) + " " + sop + " " + std::to_string(y));
+   }
+   if (sop == "=" && bool_value(e1, a) && bool_value(e2, b))
+      return F.bool_result(e, a == b, "= of Bool constants");
+   if (sop == "=" && string_value(e1, s) && string_value(e2, t))
+      return F.bool_result(e, s == t, "= of String constants");
+   if (same_variable(e1, e2))
+      return F.bool_result(e, sop != "<", "e " + sop + " e");
+   return e;
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Expression::fold
+//
+///////////////////////////////////////////////////////////////////////
+
+Expression assign_class::fold(Folder& F)
+{
+   expr = expr->fold(F);
+   return this;
+}
+
+Expression static_dispatch_class::fold(Folder& F)
+{
+   expr = expr->fold(F);
+   actual = fold_list(actual, F);
+   return this;
+}
+
+//
+// String cannot be inherited from, so a method of a String constant
+// is the runtime's.  substr out of range is a runtime error, left to
+// happen.
+//
+Expression dispatch_class::fold(Folder& F)
+{
+   expr = expr->fold(F);
+   actual = fold_list(actual, F);
+
+   Symbol s, t;
+   int i, l;
+   if (!string_value(expr, s)) return this;
+   std::string str(s->get_string(), s->get_len());
+   if (name == F.length && actual->len() == 0)
+      return F.int_result(this, str.size(), "length of a String constant");
+   if (name == F.concat && actual->len() == 1 && string_value(actual->nth(0), t))
+      return F.string_result(this, str + std::string(t->get_string(), t->get_len()),
+                             "concat of String constants");
+   if (name == F.substr && actual->len() == 2 && int_value(actual->nth(0), i)
+       && int_value(actual->nth(1), l) && i >= 0 && l >= 0 && (long long) i + l <= (long long) str.size())
+      return F.string_result(this, str.substr(i, l), "substr of a String constant");
+   return this;
+}
+
+Expression cond_class::fold(Folder& F)
+{
+   pred = pred->fold(F);
+   then_exp = then_exp->fold(F);
+   else_exp = else_exp->fold(F);
+   bool b;
+   if (!bool_value(pred, b)) return this;
+   return F.folded(this, b ? then_exp : else_exp,
+                   b ? "if true folded to its then branch" : "if false folded to its else branch");
+}
+
+Expression loop_class::fold(Folder& F)
+{
+   pred = pred->fold(F);
+   body = body->fold(F);
+   bool b;
+   if (!bool_value(pred, b) || b) return this;
+   Expression v = no_expr();
+   v->set(this);
+   return F.folded(this, v, "while false folded to void");
+}
+
+Expression typcase_class::fold(Folder& F)
+{
+   expr = expr->fold(F);
+   for (int i = cases->first(); cases->more(i); i = cases->next(i)) {
+      branch_class *b = (branch_class *) cases->nth(i);
+      b->expr = b->expr->fold(F);
+   }
+   return this;
+}
+
+//
+// Only the last expression of a block gives its value; the others
+// are there for their effects.
+//
+Expression block_class::fold(Folder& F)
+{
+   Expressions kept = nil_Expressions();
+   bool changed = false;
+   for (int i = body->first(); body->more(i); i = body->next(i)) {
+      Expression e = body->nth(i), f = e->fold(F);
+      changed = changed || f != e;
+      if (body->more(body->next(i)) && is_pure(f)) {
+         F.folded(f, f, "unused value in a block dropped");
+         changed = true;
+         continue;
+      }
+      kept = append_Expressions(kept, single_Expressions(f));
+   }
+   if (changed) body = kept;
+   return this;
+}
+
+Expression let_class::fold(Folder& F)
+{
+   init = init->fold(F);
+   body = body->fold(F);
+   return this;
+}
+
+Expression plus_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return arith(F, this, '+', e1, e2);
+}
+
+Expression sub_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return arith(F, this, '-', e1, e2);
+}
+
+Expression mul_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return arith(F, this, '*', e1, e2);
+}
+
+Expression divide_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return arith(F, this, '/', e1, e2);
+}
+
+//
+// ~ of the least Int overflows, and traps.
+//
+Expression neg_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   int x;
+   if (!int_value(e1, x) || x == INT_MIN) return this;
+   return F.int_result(this, -x, "~" + std::to_string(x));
+}
+
+Expression lt_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return compare(F, this, "<", e1, e2);
+}
+
+Expression eq_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return compare(F, this, "=", e1, e2);
+}
+
+Expression leq_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   e2 = e2->fold(F);
+   return compare(F, this, "<=", e1, e2);
+}
+
+Expression comp_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   bool b;
+   if (bool_value(e1, b))
+      return F.bool_result(this, !b, b ? "not true" : "not false");
+   if (comp_class *c = dynamic_cast<comp_class *>(e1))
+      return F.folded(this, c->e1, "not not e simplified to e");
+   return this;
+}
+
+Expression isvoid_class::fold(Folder& F)
+{
+   e1 = e1->fold(F);
+   object_class *o = dynamic_cast<object_class *>(e1);
+   if (is_constant(e1) || (o && o->name == F.self))
+      return F.bool_result(this, false, "isvoid of a constant or self");
+   return this;
+}
+
+Expression int_const_class::fold(Folder&)    { return this; }
+Expression bool_const_class::fold(Folder&)   { return this; }
+Expression string_const_class::fold(Folder&) { return this; }
+Expression new__class::fold(Folder&)         { return this; }
+Expression no_expr_class::fold(Folder&)      { return this; }
+Expression object_class::fold(Folder&)       { return this; }
+
+void program_class::fold()
+{
+   Folder F;
+   for (int i = classes->first(); classes->more(i); i = classes->next(i)) {
+      class__class *c = (class__class *) classes->nth(i);
+      F.filename = c->get_filename();
+      Features fs = c->features;
+      for (int k = fs->first(); fs->more(k); k = fs->next(k)) {
+         Feature f = fs->nth(k);
+         if (method_class *m = dynamic_cast<method_class *>(f))
+            m->expr = m->expr->fold(F);
+         else if (attr_class *a = dynamic_cast<attr_class *>(f))
+            a->init = a->init->fold(F);
+      }
+   }
+   if (cgen_debug) cerr << F.folds << " folds" << endl;
+}
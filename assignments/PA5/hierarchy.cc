@@ -0,0 +1,423 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  hierarchy.cc
+//
+//  Construction, layout and serialization of the class hierarchy
+//  shared by semant and cgen.  See hierarchy.h.
+//
+//  The serialized form is a block of lines that all start with '%',
+//  so it can precede the "#<line>" of an AST dump without ambiguity:
+//
+//      %hierarchy <number of classes>
+//      %class <name> <parent> <basic> <number of attrs> <number of methods>
+//      %attr <name> <type>
+//      %method <name> <return type> <slot> <number of formals> <type>...
+//
+//  Classes appear in tag order, each followed by its own features.
+//  Attribute offsets are implied by the order; method slots are not,
+//  since an override keeps the slot of the method it redefines.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "hierarchy.h"
+
+int ClassHierarchy::add_class(Symbol name, Symbol parent, bool basic)
+{
+   HierClass c;
+   c.name = name;
+   c.parent = parent;
+   c.basic = basic;
+   c.parent_index = -1;
+   c.attr_count = 0;
+   c.method_count = 0;
+   c.depth = 0;
+   c.last = -1;
+   index_of[name] = classes.size();
+   classes.push_back(c);
+   return classes.size() - 1;
+}
+
+void ClassHierarchy::add_attr(int c, Symbol name, Symbol type)
+{
+   HierFeature f;
+   f.name = name;
+   f.type = type;
+   f.index = -1;
+   classes[c].attrs.push_back(f);
+}
+
+void ClassHierarchy::add_method(int c, Symbol name, Symbol return_type,
+                                const std::vector<Symbol>& formals)
+{
+   HierFeature f;
+   f.name = name;
+   f.type = return_type;
+   f.index = -1;
+   f.formals = formals;
+   classes[c].methods.push_back(f);
+}
+
+int ClassHierarchy::lookup(Symbol name) const
+{
+   std::unordered_map<Symbol, int>::const_iterator it = index_of.find(name);
+   return it == index_of.end() ? -1 : it->second;
+}
+
+//
+// Number the classes in preorder and assign attribute offsets and
+// dispatch slots.  Returns false if the classes do not form a single
+// tree: an unknown parent, a second root, or a cycle.  Parents are
+// looked up once, before anything moves; index_of is only brought up
+// to date when the new order is complete.
+//
+// Slots are assigned in one pass over the preorder.  `slot_of' maps
+// every method name visible in the current class to its slot; walking
+// back up the tree undoes the entries the abandoned subtree added, so
+// each method is looked up and entered once.
+//
+bool ClassHierarchy::build()
+{
+   int n = classes.size();
+   int root = -1;
+   std::vector<std::vector<int> > kids(n);
+   std::vector<int> parent(n);
+
+   for (int i = 0; i < n; i++) {
+      int p = parent[i] = lookup(classes[i].parent);
+      if (p < 0) {
+         if (root >= 0) return false;
+         root = i;
+      } else {
+         kids[p].push_back(i);
+      }
+   }
+   if (root < 0) return false;
+
+   std::vector<int> order;
+   std::vector<int> stack(1, root);
+   order.reserve(n);
+   while (!stack.empty()) {
+      int c = stack.back();
+      stack.pop_back();
+      order.push_back(c);
+      for (int k = kids[c].size() - 1; k >= 0; k--)
+         stack.push_back(kids[c][k]);
+   }
+   if ((int) order.size() != n) return false;   // a cycle hangs off no root
+
+   std::vector<int> tag(n);
+   for (int i = 0; i < n; i++) tag[order[i]] = i;
+
+   std::vector<HierClass> sorted(n);
+   for (int i = 0; i < n; i++) {
+      HierClass& c = sorted[i];
+      c = classes[order[i]];
+      int p = parent[order[i]];
+      c.parent_index = (p < 0) ? -1 : tag[p];
+      c.children.clear();
+      for (size_t k = 0; k < kids[order[i]].size(); k++)
+         c.children.push_back(tag[kids[order[i]][k]]);
+   }
+   classes.swap(sorted);
+   for (int i = 0; i < n; i++) index_of[classes[i].name] = i;
+
+   std::unordered_map<Symbol, int> slot_of;
+   std::vector<std::pair<Symbol, int> > undo;        // name, previous slot
+   std::vector<std::pair<int, size_t> > chain;       // class, undo mark
+
+   for (int i = 0; i < n; i++) {
+      HierClass& c = classes[i];
+      while (!chain.empty() && chain.back().first != c.parent_index) {
+         size_t mark = chain.back().second;
+         chain.pop_back();
+         while (undo.size() > mark) {
+            if (undo.back().second < 0) slot_of.erase(undo.back().first);
+            else slot_of[undo.back().first] = undo.back().second;
+            undo.pop_back();
+         }
+      }
+      chain.push_back(std::make_pair(i, undo.size()));
+
+      int attrs = 0, slots = 0;
+      if (c.parent_index >= 0) {
+         attrs = classes[c.parent_index].attr_count;
+         slots = classes[c.parent_index].method_count;
+      }
+      for (size_t k = 0; k < c.attrs.size(); k++)
+         c.attrs[k].index = attrs++;
+      for (size_t k = 0; k < c.methods.size(); k++) {
+         HierFeature& m = c.methods[k];
+         std::unordered_map<Symbol, int>::iterator it = slot_of.find(m.name);
+         if (it != slot_of.end()) {
+            m.index = it->second;
+         } else {
+            m.index = slots++;
+            undo.push_back(std::make_pair(m.name, -1));
+            slot_of[m.name] = m.index;
+         }
+      }
+      c.attr_count = attrs;
+      c.method_count = slots;
+   }
+   build_tables();
+   return true;
+}
+
+//
+// Fill in depth, subtree ranges, slot introductions and dispatch tables
+// once tags, offsets and slots are known.  Parents precede children in
+// tag order, so one forward pass sees every parent's table complete.
+//
+void ClassHierarchy::build_tables()
+{
+   int n = classes.size();
+
+   for (int i = n - 1; i >= 0; i--) {
+      HierClass& c = classes[i];
+      if (c.last < i) c.last = i;
+      if (c.parent_index >= 0 && classes[c.parent_index].last < c.last)
+         classes[c.parent_index].last = c.last;
+   }
+
+   intros.clear();
+   for (int i = 0; i < n; i++) {
+      HierClass& c = classes[i];
+      int inherited = 0;
+      std::vector<bool> owned;
+
+      if (c.parent_index >= 0) {
+         HierClass& p = classes[c.parent_index];
+         c.depth = p.depth + 1;
+         c.dispatch = p.dispatch;
+         inherited = p.method_count;
+      }
+      owned.assign(c.dispatch.size(), false);
+      while ((int) c.dispatch.size() * DISPATCH_BLOCK < c.method_count) {
+         HierMethodRef empty = { -1, NULL };
+         c.dispatch.push_back(new DispatchBlock(DISPATCH_BLOCK, empty));
+         owned.push_back(true);
+      }
+
+      // An override goes in the inherited slot; of several methods with
+      // one name in a class, the first is the one dispatch reaches.
+      for (size_t k = 0; k < c.methods.size(); k++) {
+         HierFeature& m = c.methods[k];
+         int b = m.index / DISPATCH_BLOCK;
+         if (!owned[b]) {
+            c.dispatch[b] = new DispatchBlock(*c.dispatch[b]);
+            owned[b] = true;
+         }
+         HierMethodRef& entry = (*c.dispatch[b])[m.index % DISPATCH_BLOCK];
+         if (entry.cls == i) continue;
+         entry.cls = i;
+         entry.method = &m;
+         if (m.index >= inherited) {
+            SlotIntro intro = { i, c.last, m.index };
+            intros[m.name].push_back(intro);
+         }
+      }
+   }
+}
+
+//
+// The classes that introduce a name have disjoint subtrees and are
+// recorded in tag order, so the only candidate for `c' is the last one
+// at or before it.
+//
+int ClassHierarchy::find_slot(int c, Symbol name)
+{
+   std::unordered_map<Symbol, std::vector<SlotIntro> >::iterator it = intros.find(name);
+   if (it == intros.end()) return -1;
+   std::vector<SlotIntro>& v = it->second;
+   int lo = 0, hi = v.size();
+   while (lo < hi) {                  // first intro starting after c
+      int mid = (lo + hi) / 2;
+      if (v[mid].first <= c) lo = mid + 1;
+      else hi = mid;
+   }
+   if (lo == 0 || v[lo - 1].last < c) return -1;
+   return v[lo - 1].slot;
+}
+
+//
+// What the slot holds in `c' and every class below it.  The subtree is
+// a range of tags, each class following its parent, and a class that
+// does not change the slot's block shares it with its parent.
+//
+void ClassHierarchy::implementations(int c, int slot, std::vector<HierMethodRef>& out)
+{
+   out.clear();
+   DispatchBlock *seen = NULL;
+   for (int d = c; d <= classes[c].last; d++) {
+      DispatchBlock *block = classes[d].dispatch[slot / DISPATCH_BLOCK];
+      if (block == seen) continue;
+      seen = block;
+      HierMethodRef m = (*block)[slot % DISPATCH_BLOCK];
+      size_t k = 0;
+      while (k < out.size() && (out[k].cls != m.cls || out[k].method != m.method)) k++;
+      if (k == out.size()) out.push_back(m);
+   }
+}
+
+void ClassHierarchy::attr_layout(int c, std::vector<std::pair<int, HierFeature *> >& out)
+{
+   out.assign(classes[c].attr_count, std::pair<int, HierFeature *>(-1, NULL));
+   for (int a = c; a >= 0; a = classes[a].parent_index)
+      for (size_t k = 0; k < classes[a].attrs.size(); k++) {
+         HierFeature& f = classes[a].attrs[k];
+         out[f.index] = std::make_pair(a, &f);
+      }
+}
+
+void ClassHierarchy::dispatch_layout(int c, std::vector<std::pair<int, HierFeature *> >& out)
+{
+   out.resize(classes[c].method_count);
+   for (int s = 0; s < classes[c].method_count; s++) {
+      HierMethodRef r = dispatch(c, s);
+      out[s] = std::make_pair(r.cls, r.method);
+   }
+}
+
+void ClassHierarchy::dump(ostream& s)
+{
+   s << "%hierarchy " << classes.size() << "\n";
+   for (size_t i = 0; i < classes.size(); i++) {
+      HierClass& c = classes[i];
+      s << "%class " << c.name << " " << c.parent << " " << (c.basic ? 1 : 0)
+        << " " << c.attrs.size() << " " << c.methods.size() << "\n";
+      for (size_t k = 0; k < c.attrs.size(); k++)
+         s << "%attr " << c.attrs[k].name << " " << c.attrs[k].type << "\n";
+      for (size_t k = 0; k < c.methods.size(); k++) {
+         HierFeature& m = c.methods[k];
+         s << "%method " << m.name << " " << m.type << " " << m.index
+           << " " << m.formals.size();
+         for (size_t j = 0; j < m.formals.size(); j++)
+            s << " " << m.formals[j];
+         s << "\n";
+      }
+   }
+}
+
+//
+// A line reader that splits on blanks and interns every word after the
+// leading '%'-keyword in the identifier table.
+//
+class HierReader {
+private:
+   FILE *f;
+   int lineno;
+   std::vector<std::string> words;
+   size_t pos;
+public:
+   HierReader(FILE *file) : f(file), lineno(0), pos(0) { }
+
+   void next_line(const char *keyword)
+   {
+      std::string line;
+      int ch;
+      while ((ch = getc(f)) != EOF && ch != '\n')
+         line.push_back((char) ch);
+      lineno++;
+      words.clear();
+      pos = 0;
+      size_t i = 0;
+      while (i < line.size()) {
+         while (i < line.size() && line[i] == ' ') i++;
+         size_t start = i;
+         while (i < line.size() && line[i] != ' ') i++;
+         if (i > start) words.push_back(line.substr(start, i - start));
+      }
+      if (words.empty() || words[0] != keyword) malformed();
+      pos = 1;
+   }
+
+   Symbol symbol()
+   {
+      if (pos >= words.size()) malformed();
+      std::string& w = words[pos++];
+      return idtable.add_string((char *) w.c_str());
+   }
+
+   int number()
+   {
+      if (pos >= words.size()) malformed();
+      std::string& w = words[pos++];
+      char *end;
+      long v = strtol(w.c_str(), &end, 10);
+      if (*end != '\0' || v < 0) malformed();
+      return (int) v;
+   }
+
+   void malformed()
+   {
+      cerr << "malformed class hierarchy at line " << lineno << "\n";
+      exit(1);
+   }
+};
+
+//
+// Read a hierarchy printed by dump() from the front of `f', leaving `f'
+// at the first character after it.  Returns NULL, consuming nothing, if
+// `f' does not start with one.
+//
+ClassHierarchy *ClassHierarchy::read(FILE *f)
+{
+   int ch = getc(f);
+   if (ch != EOF) ungetc(ch, f);
+   if (ch != '%') return NULL;
+
+   HierReader in(f);
+   ClassHierarchy *h = new ClassHierarchy;
+   in.next_line("%hierarchy");
+   int n = in.number();
+   h->classes.reserve(n);
+
+   for (int i = 0; i < n; i++) {
+      in.next_line("%class");
+      Symbol name = in.symbol();
+      Symbol parent = in.symbol();
+      bool basic = in.number() != 0;
+      int nattrs = in.number();
+      int nmethods = in.number();
+
+      int c = h->add_class(name, parent, basic);
+      HierClass& hc = h->classes[c];
+      hc.parent_index = h->lookup(parent);
+      if (i == 0 ? hc.parent_index >= 0 : (hc.parent_index < 0 || hc.parent_index >= c))
+         in.malformed();
+
+      int attrs = 0, slots = 0;
+      if (hc.parent_index >= 0) {
+         HierClass& p = h->classes[hc.parent_index];
+         p.children.push_back(c);
+         attrs = p.attr_count;
+         slots = p.method_count;
+      }
+      for (int k = 0; k < nattrs; k++) {
+         in.next_line("%attr");
+         Symbol aname = in.symbol();
+         h->add_attr(c, aname, in.symbol());
+         hc.attrs.back().index = attrs++;
+      }
+      for (int k = 0; k < nmethods; k++) {
+         in.next_line("%method");
+         Symbol mname = in.symbol();
+         Symbol type = in.symbol();
+         int slot = in.number();
+         int nformals = in.number();
+         std::vector<Symbol> formals;
+         for (int j = 0; j < nformals; j++)
+            formals.push_back(in.symbol());
+         h->add_method(c, mname, type, formals);
+         hc.methods.back().index = slot;
+         if (slot >= slots) slots = slot + 1;
+      }
+      hc.attr_count = attrs;
+      hc.method_count = slots;
+   }
+   h->build_tables();
+   return h;
+}
@@ -0,0 +1,127 @@
+#ifndef HIERARCHY_H_
+#define HIERARCHY_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  hierarchy.h
+//
+//  ClassHierarchy is the inheritance graph as semantic analysis leaves
+//  it: every class with its parent and children, its own attributes
+//  and methods, and the attribute offsets and dispatch slots they end
+//  up at once inherited features are laid out in front of them.
+//
+//  semant builds it after a successful check and, with -h, prints it
+//  ahead of the annotated AST; cgen reads it back and sets up its class
+//  table from it instead of re-installing and re-linking every class.
+//  The structure does not refer to the AST, so both phases share this
+//  file and only fill it in differently:
+//
+//      ClassHierarchy h;
+//      int c = h.add_class(name, parent, basic);
+//      h.add_attr(c, attr_name, type_decl);
+//      h.add_method(c, method_name, return_type, formal_types);
+//      ...
+//      if (h.build()) h.dump(out);
+//
+//  After build() the classes are numbered in depth-first preorder from
+//  Object, children in declaration order, so a class's number is a
+//  usable class tag and every subtree is a contiguous range of tags.
+//
+//  Only a class's own features are stored.  An attribute's index is its
+//  offset among all attributes of the class (inherited ones first); a
+//  method's index is its dispatch slot, which an override shares with
+//  the method it redefines.  The attribute layout of a class is the
+//  chain of its ancestors' own attributes.
+//
+//  Every class also gets a flattened dispatch table: for each slot, the
+//  class and method a dispatch through it reaches.  Tables are split
+//  into blocks of DISPATCH_BLOCK slots, and a class copies only the
+//  blocks its own methods change, sharing the rest with its parent, so
+//  deep hierarchies do not pay for a full table per class.  With
+//  find_slot, resolving a method by name is a hash probe, a binary
+//  search among the classes that introduce that name, and an index.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <vector>
+#include <unordered_map>
+#include "cool-io.h"
+#include "stringtab.h"
+
+struct HierFeature {
+   Symbol name;
+   Symbol type;                   // attribute type / method return type
+   int index;                     // attribute offset / dispatch slot
+   std::vector<Symbol> formals;   // formal parameter types (methods only)
+};
+
+struct HierMethodRef {
+   int cls;                       // declaring class, -1 for an empty slot
+   HierFeature *method;
+};
+
+#define DISPATCH_BLOCK 32
+typedef std::vector<HierMethodRef> DispatchBlock;
+
+struct HierClass {
+   Symbol name;
+   Symbol parent;                 // No_class for Object
+   bool basic;
+   int parent_index;              // -1 for Object
+   std::vector<int> children;
+   std::vector<HierFeature> attrs;
+   std::vector<HierFeature> methods;
+   int attr_count;                // attributes including inherited ones
+   int method_count;              // size of the dispatch table
+   int depth;                     // 0 for Object
+   int last;                      // last tag in this class's subtree
+   std::vector<DispatchBlock *> dispatch;
+};
+
+struct SlotIntro {                // a class that gives a method name a slot
+   int first, last;               // ... and the subtree that sees it
+   int slot;
+};
+
+class ClassHierarchy {
+private:
+   std::vector<HierClass> classes;
+   std::unordered_map<Symbol, int> index_of;
+   std::unordered_map<Symbol, std::vector<SlotIntro> > intros;
+   void build_tables();
+public:
+   int add_class(Symbol name, Symbol parent, bool basic);
+   void add_attr(int c, Symbol name, Symbol type);
+   void add_method(int c, Symbol name, Symbol return_type,
+                   const std::vector<Symbol>& formals);
+   bool build();
+
+   int size() const { return classes.size(); }
+   HierClass& operator[](int c) { return classes[c]; }
+   int lookup(Symbol name) const;
+   bool inherits(int c, int ancestor) const {
+      return ancestor <= c && c <= classes[ancestor].last;
+   }
+
+   // Method resolution: the slot `name' has in `c' (-1 if `c' has no
+   // such method), and what a dispatch on `c' through `slot' reaches.
+   int find_slot(int c, Symbol name);
+   HierMethodRef dispatch(int c, int slot) {
+      return (*classes[c].dispatch[slot / DISPATCH_BLOCK])[slot % DISPATCH_BLOCK];
+   }
+
+   // Class hierarchy analysis: the methods a dispatch through `slot' on
+   // an object of static class `c' may reach, one per implementation.
+   void implementations(int c, int slot, std::vector<HierMethodRef>& out);
+
+   // The features of `c' by attribute offset and by dispatch slot, with
+   // the class that declares each.
+   void attr_layout(int c, std::vector<std::pair<int, HierFeature *> >& out);
+   void dispatch_layout(int c, std::vector<std::pair<int, HierFeature *> >& out);
+
+   void dump(ostream& s);
+   static ClassHierarchy *read(FILE *f);
+};
+
+#endif
@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  inline.cc
+//
+//  Inlining of small methods for cgen -O; see inline.h.  Methods are
+//  taken callees first, so what is copied into a caller is the callee
+//  with its own small calls already inlined; a call back into a method
+//  still being worked on, recursion, is left as a call.
+//
+//  A method is small if it has at most INLINE_SIZE instructions, not
+//  counting its PARAMs, and a function takes in at most INLINE_BUDGET
+//  instructions all told; past that its calls stay calls.  Only a
+//  method from the caller's own file is inlined, since the aborts in
+//  its body name the file of the function they end up in.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <map>
+#include <string>
+#include "emit.h"
+#include "inline.h"
+
+#define INLINE_SIZE   12
+#define INLINE_BUDGET 48
+
+class Inliner {
+private:
+   std::vector<IrFunction *>& fns;
+   std::map<std::string, int> index;           // function by name
+   std::vector<int> state;                     // 0 not yet, 1 under way, 2 done
+   int sites, inlined;
+
+   static int cost(const IrFunction& g);
+   void expand(IrFunction& f, int b, int i, const IrFunction& g);
+   void inline_into(int n);
+public:
+   Inliner(std::vector<IrFunction *>& functions);
+   int run(bool report);
+};
+
+Inliner::Inliner(std::vector<IrFunction *>& functions) :
+   fns(functions), state(functions.size(), 0), sites(0), inlined(0)
+{
+   for (size_t i = 0; i < fns.size(); i++) index[fns[i]->name] = i;
+}
+
+int Inliner::cost(const IrFunction& g)
+{
+   int n = 0;
+   for (size_t b = 0; b < g.blocks.size(); b++)
+      for (size_t i = 0; i < g.blocks[b].insns.size(); i++)
+         if (g.blocks[b].insns[i].op != IR_PARAM) n++;
+   return n;
+}
+
+//
+// Replaces instruction i of block b, an SCALL of `g', with a copy of
+// g's blocks.  What follows the call in b moves to a block of its own,
+// which the copy's RETs jump to.
+//
+void Inliner::expand(IrFunction& f, int b, int i, const IrFunction& g)
+{
+   IrInsn call = f.blocks[b].insns[i];
+   int base = f.nregs, first = f.blocks.size(), rest = first + g.blocks.size();
+   f.nregs += g.nregs;
+
+   for (size_t k = 0; k < g.blocks.size(); k++) {
+      const IrBlock& gb = g.blocks[k];
+      IrBlock nb;
+      for (size_t j = 0; j < gb.insns.size(); j++) {
+         IrInsn in = gb.insns[j];
+         if (in.dst >= 0) in.dst += base;
+         if (in.a >= 0) in.a += base;
+         if (in.b >= 0) in.b += base;
+         for (size_t m = 0; m < in.args.size(); m++) in.args[m] += base;
+         if (in.op == IR_PARAM) {
+            in.op = IR_MOVE;
+            in.a = in.imm == 0 ? call.a : call.args[in.imm - 1];
+            in.imm = 0;
+         } else if (in.op == IR_RET) {
+            nb.insns.push_back(IrInsn(IR_MOVE, call.dst, in.a));
+            in = IrInsn(IR_JMP);
+            nb.succs.push_back(rest);
+         }
+         nb.insns.push_back(in);
+      }
+      for (size_t m = 0; m < gb.succs.size(); m++) nb.succs.push_back(gb.succs[m] + first);
+      f.blocks.push_back(nb);
+   }
+
+   IrBlock after;
+   after.insns.assign(f.blocks[b].insns.begin() + i + 1, f.blocks[b].insns.end());
+   after.succs.swap(f.blocks[b].succs);
+   f.blocks.push_back(after);
+
+   IrBlock& bl = f.blocks[b];
+   bl.insns.erase(bl.insns.begin() + i, bl.insns.end());
+   IrInsn check(IR_CHECK, -1, call.a);
+   check.line = call.line;
+   check.nonvoid = call.nonvoid;
+   bl.insns.push_back(check);
+   bl.insns.push_back(IrInsn(IR_JMP));
+   bl.succs.assign(1, first);
+}
+
+//
+// The blocks a copy brings in are not looked at again; their calls
+// were already weighed in the method they came from.
+//
+void Inliner::inline_into(int n)
+{
+   state[n] = 1;
+   IrFunction& f = *fns[n];
+   std::vector<bool> own(f.blocks.size(), true);
+   int taken = 0;
+   for (size_t b = 0; b < f.blocks.size(); b++) {
+      if (!own[b]) continue;
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         const IrInsn& in = f.blocks[b].insns[i];
+         if (in.op != IR_SCALL) continue;
+         std::map<std::string, int>::iterator g = index.find(
+            std::string(in.cls->get_string()) + METHOD_SEP + in.sym->get_string());
+         if (g == index.end()) continue;
+         sites++;
+         if (state[g->second] == 1) continue;
+         if (state[g->second] == 0) inline_into(g->second);
+
+         const IrFunction& callee = *fns[g->second];
+         int c = cost(callee);
+         if (callee.file != f.file || c > INLINE_SIZE || taken + c > INLINE_BUDGET) continue;
+         expand(f, b, i, callee);
+         own.resize(f.blocks.size(), false);
+         own.back() = true;
+         taken += c;
+         inlined++;
+         break;
+      }
+   }
+   state[n] = 2;
+}
+
+int Inliner::run(bool report)
+{
+   for (size_t n = 0; n < fns.size(); n++)
+      if (state[n] == 0) inline_into(n);
+   if (report) cerr << inlined << " of " << sites << " direct calls inlined" << endl;
+   return inlined;
+}
+
+int inline_calls(std::vector<IrFunction *>& functions, bool report)
+{
+   return Inliner(functions).run(report);
+}
@@ -0,0 +1,25 @@
+#ifndef INLINE_H_
+#define INLINE_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  inline.h
+//
+//  With -O, a call that goes to one known method (an SCALL, which a
+//  dispatch becomes when only one method can answer it) is replaced by
+//  a copy of that method's body if the body is small.  The receiver
+//  and arguments are moved into the copy's self and formals, its RETs
+//  into the call's result, and a CHECK in front aborts as the call
+//  would have if the receiver is void.  This runs on the IR as lowered,
+//  before IrFunction::build_cfg and optimize.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "ir.h"
+
+// Inlines the small SCALLs of `functions' and returns how many there
+// were.  With `report' the count is printed on cerr.
+int inline_calls(std::vector<IrFunction *>& functions, bool report);
+
+#endif
@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  ir.cc
+//
+//  The control flow graph of an IrFunction and the listing cgen -c
+//  prints of it.  See ir.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "ir.h"
+#include "utilities.h"
+
+const char *ir_op_names[] = {
+#define IR_NAME(op, name) name,
+   IR_OPS(IR_NAME)
+#undef IR_NAME
+};
+
+void IrInsn::uses(std::vector<int>& out) const
+{
+   out.clear();
+   if (a >= 0) out.push_back(a);
+   if (b >= 0) out.push_back(b);
+   out.insert(out.end(), args.begin(), args.end());
+}
+
+//
+// Blocks are renumbered in depth-first preorder from the entry, first
+// successors first, which is also the order they are written out in:
+// the true side of a branch and the body of a loop fall through from
+// the test.
+//
+void IrFunction::build_cfg()
+{
+   std::vector<int> number(blocks.size(), -1);
+   std::vector<int> order, work(1, 0);
+   while (!work.empty()) {
+      int b = work.back();
+      work.pop_back();
+      if (number[b] >= 0) continue;
+      number[b] = order.size();
+      order.push_back(b);
+      for (int i = blocks[b].succs.size() - 1; i >= 0; i--)
+         if (number[blocks[b].succs[i]] < 0) work.push_back(blocks[b].succs[i]);
+   }
+
+   std::vector<IrBlock> kept(order.size());
+   for (size_t i = 0; i < order.size(); i++) {
+      kept[i].insns.swap(blocks[order[i]].insns);
+      kept[i].succs.swap(blocks[order[i]].succs);
+   }
+   blocks.swap(kept);
+   for (size_t b = 0; b < blocks.size(); b++)
+      for (size_t i = 0; i < blocks[b].succs.size(); i++) {
+         int s = blocks[b].succs[i] = number[blocks[b].succs[i]];
+         blocks[s].preds.push_back(b);
+      }
+}
+
+//
+// The usual backward dataflow, iterated until nothing changes.  Blocks
+// are visited last to first, which is close to reverse postorder for
+// the depth-first layout build_cfg leaves.
+//
+void IrFunction::liveness(std::vector<std::vector<bool> >& live_in,
+                          std::vector<std::vector<bool> >& live_out)
+{
+   int n = blocks.size();
+   live_in.assign(n, std::vector<bool>(nregs, false));
+   live_out.assign(n, std::vector<bool>(nregs, false));
+   std::vector<int> uses;
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (int b = n - 1; b >= 0; b--) {
+         std::vector<bool> live(nregs, false);
+         for (size_t i = 0; i < blocks[b].succs.size(); i++) {
+            std::vector<bool>& in = live_in[blocks[b].succs[i]];
+            for (int r = 0; r < nregs; r++)
+               if (in[r]) live[r] = true;
+         }
+         live_out[b] = live;
+         for (int i = blocks[b].insns.size() - 1; i >= 0; i--) {
+            IrInsn& in = blocks[b].insns[i];
+            if (in.dst >= 0) live[in.dst] = false;
+            in.uses(uses);
+            for (size_t k = 0; k < uses.size(); k++) live[uses[k]] = true;
+         }
+         if (live != live_in[b]) {
+            live_in[b].swap(live);
+            changed = true;
+         }
+      }
+   }
+}
+
+//
+// Copies and phis hold numbers if what they copy does; nothing mixes
+// the two kinds in one register.
+//
+void IrFunction::numbers(std::vector<bool>& number) const
+{
+   number.assign(nregs, false);
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (size_t b = 0; b < blocks.size(); b++)
+         for (size_t i = 0; i < blocks[b].insns.size(); i++) {
+            const IrInsn& in = blocks[b].insns[i];
+            if (in.dst < 0 || number[in.dst]) continue;
+            bool n;
+            switch (in.op) {
+            case IR_UNBOX: case IR_IMM: case IR_RADD: case IR_RSUB: case IR_RMUL:
+            case IR_RDIV: case IR_RNEG: case IR_RLT: case IR_RLE: case IR_REQ: case IR_RNOT:
+               n = true;
+               break;
+            case IR_MOVE:
+               n = number[in.a];
+               break;
+            case IR_PHI:
+               n = false;
+               for (size_t k = 0; k < in.args.size(); k++) n = n || number[in.args[k]];
+               break;
+            default:
+               n = false;
+               break;
+            }
+            if (n) number[in.dst] = changed = true;
+         }
+   }
+}
+
+int IrFunction::size() const
+{
+   int n = 0;
+   for (size_t b = 0; b < blocks.size(); b++) n += blocks[b].insns.size();
+   return n;
+}
+
+static void dump_reg(ostream& s, int r)
+{
+   s << " v" << r;
+}
+
+void IrFunction::dump(ostream& s)
+{
+   s << "# " << name << " (" << nformals << " formals, " << nregs << " registers)\n";
+   for (size_t b = 0; b < blocks.size(); b++) {
+      IrBlock& bl = blocks[b];
+      s << "# B" << b << ":";
+      if (!bl.preds.empty()) {
+         s << "\t\t\tpreds";
+         for (size_t i = 0; i < bl.preds.size(); i++) s << " B" << bl.preds[i];
+      }
+      s << "\n";
+      for (size_t i = 0; i < bl.insns.size(); i++) {
+         IrInsn& in = bl.insns[i];
+         s << "#   ";
+         if (in.dst >= 0) s << "v" << in.dst << " = ";
+         s << ir_op_names[in.op];
+         switch (in.op) {
+         case IR_PARAM: case IR_BOOL: case IR_IMM:
+            s << " " << in.imm;
+            break;
+         case IR_INT:
+            s << " " << in.sym;
+            break;
+         case IR_STR:
+            s << " \"";
+            print_escaped_string(s, in.sym->get_string());
+            s << "\"";
+            break;
+         case IR_NEW: case IR_STACKNEW: case IR_INIT:
+            s << " " << in.cls;
+            break;
+         case IR_CALL: case IR_SCALL:
+            if (in.op == IR_SCALL) s << " " << in.cls;
+            s << " " << in.sym << "[" << in.imm << "]";
+            break;
+         default:
+            break;
+         }
+         if (in.a >= 0) dump_reg(s, in.a);
+         if (in.b >= 0) dump_reg(s, in.b);
+         for (size_t k = 0; k < in.args.size(); k++) dump_reg(s, in.args[k]);
+         if (in.op == IR_GETATTR || in.op == IR_SETATTR) s << " @" << in.imm;
+         if (in.op == IR_BRRANGE) s << " " << in.imm << ".." << in.imm2;
+         for (size_t k = 0; k < bl.succs.size() && in.is_terminator(); k++)
+            s << " B" << bl.succs[k];
+         if (in.is_call() || in.op == IR_CHECK || in.op == IR_TAG)
+            s << "\t\tline " << in.line;
+         s << "\n";
+      }
+   }
+}
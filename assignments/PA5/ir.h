@@ -0,0 +1,153 @@
+#ifndef IR_H_
+#define IR_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  ir.h
+//
+//  The three-address code cgen lowers every method and initializer to
+//  before it writes MIPS.  A function is a list of basic blocks over
+//  virtual registers; block 0 is the entry, and every block ends in
+//  exactly one terminator, whose successors make up the control flow
+//  graph.  Expression::code (cgen.cc) builds the blocks, IrFunction
+//  fills in predecessors and drops what cannot be reached, and
+//  CgenClassTable turns the result into MIPS.
+//
+//  Registers hold what COOL values are at run time, pointers to
+//  objects (Ints and Bools boxed) or void, with two exceptions: the
+//  class tag TAG reads for a case, and under -O the numbers that
+//  UNBOX, IMM and the R operations compute, Ints and Bools (as 0 or 1)
+//  that optimize.cc has taken out of their boxes.  BR branches on
+//  either a Bool or such a number.  A register is written by any
+//  number of instructions; locals and formals are registers that
+//  assignments write again.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include "cool-io.h"
+#include "stringtab.h"
+
+//
+// Operations, with what they do.  d is the register written, a and b
+// those read.
+//
+#define IR_OPS(X)                                                       \
+   X(PARAM,     "param")     /* d = self (imm 0) or formal imm        */ \
+   X(INT,       "int")       /* d = Int constant sym                  */ \
+   X(STR,       "str")       /* d = String constant sym               */ \
+   X(BOOL,      "bool")      /* d = Bool imm                          */ \
+   X(VOID,      "void")      /* d = void                              */ \
+   X(MOVE,      "move")      /* d = a                                 */ \
+   X(GETATTR,   "getattr")   /* d = attribute imm of a                */ \
+   X(SETATTR,   "setattr")   /* attribute imm of a = b                */ \
+   X(ADD,       "add")       /* d = a + b on Ints, likewise SUB, ...  */ \
+   X(SUB,       "sub")                                                  \
+   X(MUL,       "mul")                                                  \
+   X(DIV,       "div")                                                  \
+   X(NEG,       "neg")       /* d = ~a                                */ \
+   X(LT,        "lt")        /* d = a < b on Ints                     */ \
+   X(LE,        "le")        /* d = a <= b on Ints                    */ \
+   X(EQ,        "eq")        /* d = a = b on Ints or Bools            */ \
+   X(EQUAL,     "equal")     /* d = a = b on any objects              */ \
+   X(NOT,       "not")       /* d = not a                             */ \
+   X(ISVOID,    "isvoid")    /* d = isvoid a                          */ \
+   X(NEW,       "new")       /* d = new cls, initialized              */ \
+   X(STACKNEW,  "stacknew")  /* likewise, in the frame (-O)           */ \
+   X(NEWSELF,   "newself")   /* d = new SELF_TYPE of a                */ \
+   X(INIT,      "init")      /* run cls's initializer on a            */ \
+   X(CALL,      "call")      /* d = a.sym(args...) through slot imm   */ \
+   X(SCALL,     "scall")     /* d = a.sym(args...) of class cls       */ \
+   X(CHECK,     "check")     /* abort as a call would if a is void    */ \
+   X(TAG,       "tag")       /* d = class tag of a                    */ \
+   X(UNBOX,     "unbox")     /* d = the number in Int or Bool a (-O)  */ \
+   X(BOX,       "box")       /* d = new Int holding number a          */ \
+   X(BOXBOOL,   "boxbool")   /* d = the Bool for number a             */ \
+   X(IMM,       "imm")       /* d = number imm                        */ \
+   X(RADD,      "radd")      /* d = a + b on numbers, likewise ...    */ \
+   X(RSUB,      "rsub")                                                 \
+   X(RMUL,      "rmul")                                                 \
+   X(RDIV,      "rdiv")                                                 \
+   X(RNEG,      "rneg")                                                 \
+   X(RLT,       "rlt")       /* d = 1 if a < b else 0, likewise ...   */ \
+   X(RLE,       "rle")                                                  \
+   X(REQ,       "req")                                                  \
+   X(RNOT,      "rnot")      /* d = 1 - a                             */ \
+   X(PHI,       "phi")       /* d = args[i] coming from pred i (-O)   */ \
+   X(JMP,       "jmp")       /* goto succ 0                           */ \
+   X(BR,        "br")        /* goto succ 0 if a else succ 1          */ \
+   X(BRRANGE,   "brrange")   /* goto succ 0 if imm <= a <= imm2, ...  */ \
+   X(RET,       "ret")       /* return a                              */ \
+   X(CASEABORT, "caseabort") /* no branch of a case matches a         */
+
+enum IrOp {
+#define IR_ENUM(op, name) IR_##op,
+   IR_OPS(IR_ENUM)
+#undef IR_ENUM
+   IR_OP_COUNT
+};
+
+extern const char *ir_op_names[];
+
+struct IrInsn {
+   IrOp op;
+   int dst;                       // register written, -1 if none
+   int a, b;                      // registers read, -1 if unused
+   std::vector<int> args;         // call arguments, first to last
+   int imm, imm2;                 // attribute, slot, formal or tag range
+   Symbol sym;                    // constant or method name
+   Symbol cls;                    // class of NEW, INIT and SCALL
+   int line;                      // for the aborts that report one
+   bool nonvoid;                  // a of CALL, SCALL, CHECK or TAG is never void
+
+   IrInsn(IrOp o, int d = -1, int x = -1, int y = -1) :
+      op(o), dst(d), a(x), b(y), imm(0), imm2(0), sym(NULL), cls(NULL), line(0),
+      nonvoid(false) { }
+
+   bool is_terminator() const { return op >= IR_JMP; }
+   bool is_call() const { return op == IR_CALL || op == IR_SCALL; }
+
+   // The registers the instruction reads, in order.
+   void uses(std::vector<int>& out) const;
+};
+
+struct IrBlock {
+   std::vector<IrInsn> insns;     // the last one is the terminator
+   std::vector<int> succs;        // in the terminator's order
+   std::vector<int> preds;
+
+   IrInsn& terminator() { return insns.back(); }
+};
+
+struct IrFunction {
+   std::string name;              // "Class.method" or "Class_init"
+   Symbol cls;
+   Symbol file;                   // for dispatch and case aborts
+   int nformals;
+   int nregs;
+   std::vector<IrBlock> blocks;
+
+   IrFunction(const std::string& n, Symbol c, Symbol f, int formals) :
+      name(n), cls(c), file(f), nformals(formals), nregs(0) { }
+
+   int new_reg() { return nregs++; }
+
+   // Fills in the predecessors from the terminators, removes the
+   // blocks the entry does not reach and renumbers the rest in the
+   // order they are written out in.
+   void build_cfg();
+
+   // The registers live on entry to and exit from every block.
+   void liveness(std::vector<std::vector<bool> >& live_in,
+                 std::vector<std::vector<bool> >& live_out);
+
+   // Which registers hold numbers rather than objects.  The collector
+   // must never find one of those where it looks for pointers.
+   void numbers(std::vector<bool>& number) const;
+
+   int size() const;
+   void dump(ostream& s);
+};
+
+#endif
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  mips.cc
+//
+//  Printing a MipsCode.  See mips.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include <string.h>
+#include "emit.h"
+#include "mips.h"
+#include "outbuf.h"
+
+const char *mips_op_names[] = {
+#define MIPS_NAME(op, name) name,
+   MIPS_OPS(MIPS_NAME)
+#undef MIPS_NAME
+};
+
+const char *mips_reg_names[] = {
+   "$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+   "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+   "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+   "$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"
+};
+
+//
+// The names cgen passes are mostly the strings above, or the literals
+// of emit.h, so the pointers are tried first.
+//
+int mips_reg(const char *name)
+{
+   for (int r = 0; r < 32; r++)
+      if (name == mips_reg_names[r]) return r;
+   for (int r = 0; r < 32; r++)
+      if (strcmp(name, mips_reg_names[r]) == 0) return r;
+   assert(0);
+   return -1;
+}
+
+void MipsAddr::print(ostream& s) const
+{
+   switch (kind) {
+   case ADDR_LABEL:   s << "label" << fast_int(n); break;
+   case ADDR_NAME:    s << name; break;
+   case ADDR_PROTOBJ: s << sym << PROTOBJ_SUFFIX; break;
+   case ADDR_INIT:    s << sym << CLASSINIT_SUFFIX; break;
+   case ADDR_METHOD:  s << cls << METHOD_SEP << sym; break;
+   case ADDR_INT:     ((IntEntry *) sym)->code_ref(s); break;
+   case ADDR_STR:     ((StringEntry *) sym)->code_ref(s); break;
+   case ADDR_BOOL:    s << BOOLCONST_PREFIX << n; break;
+   }
+}
+
+void MipsInsn::print(ostream& os) const
+{
+   if (op == MIPS_LABEL) {
+      addr.print(os);
+      os << LABEL;
+      return;
+   }
+   os << "\t" << mips_op_names[op] << "\t";
+   switch (op) {
+   case MIPS_LW: case MIPS_SW:
+      os << mips_reg_names[d] << " " << fast_int(imm) << "(" << mips_reg_names[s] << ")";
+      break;
+   case MIPS_LI:
+      os << mips_reg_names[d] << " " << fast_int(imm);
+      break;
+   case MIPS_LA:
+      os << mips_reg_names[d] << " ";
+      addr.print(os);
+      break;
+   case MIPS_MOVE: case MIPS_NEG:
+      os << mips_reg_names[d] << " " << mips_reg_names[s];
+      break;
+   case MIPS_ADD: case MIPS_ADDU: case MIPS_DIV: case MIPS_MUL: case MIPS_SUB:
+   case MIPS_SLT: case MIPS_SLE: case MIPS_SEQ:
+      os << mips_reg_names[d] << " " << mips_reg_names[s] << " " << mips_reg_names[t];
+      break;
+   case MIPS_ADDIU: case MIPS_SLL: case MIPS_XORI:
+      os << mips_reg_names[d] << " " << mips_reg_names[s] << " " << fast_int(imm);
+      break;
+   case MIPS_JALR:
+      os << "\t" << mips_reg_names[s];
+      break;
+   case MIPS_JR:
+      os << mips_reg_names[s] << "\t";
+      break;
+   case MIPS_JAL: case MIPS_B:
+      addr.print(os);
+      break;
+   case MIPS_BEQZ:
+      os << mips_reg_names[s] << " ";
+      addr.print(os);
+      break;
+   default:
+      os << mips_reg_names[s] << " ";
+      if (t >= 0) os << mips_reg_names[t]; else os << fast_int(imm);
+      os << " ";
+      addr.print(os);
+   }
+   os << "\n";
+}
+
+int MipsCode::size() const
+{
+   int n = 0;
+   for (size_t i = 0; i < insns.size(); i++)
+      if (insns[i].op != MIPS_LABEL) n++;
+   return n;
+}
+
+void MipsCode::print(ostream& s) const
+{
+   for (size_t i = 0; i < insns.size(); i++) insns[i].print(s);
+}
@@ -0,0 +1,131 @@
+#ifndef MIPS_H_
+#define MIPS_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  mips.h
+//
+//  The MIPS of one function as FunctionCoder writes it, held as
+//  instructions rather than text until it is printed.  The emit_*
+//  procedures of cgen.cc append to a MipsCode; the peephole pass
+//  (peephole.h) rewrites it under -O; print() then writes exactly the
+//  spim syntax those procedures used to write directly.
+//
+//  Registers are MIPS numbers, as in Allocation.  Addresses, the
+//  operands of la, jal and the branches, stay symbolic until printing.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "cool-io.h"
+#include "stringtab.h"
+
+//
+// Opcodes, with their operands.  d, s and t are registers, i an
+// immediate or byte offset, A an address.
+//
+#define MIPS_OPS(X)                                                     \
+   X(LABEL, "")                   /* A:                                */ \
+   X(LW,    "lw")                 /* d i(s)                            */ \
+   X(SW,    "sw")                 /* d i(s), d is stored               */ \
+   X(LI,    "li")                 /* d i                               */ \
+   X(LA,    "la")                 /* d A                               */ \
+   X(MOVE,  "move")               /* d s                               */ \
+   X(NEG,   "neg")                /* d s                               */ \
+   X(ADD,   "add")                /* d s t                             */ \
+   X(ADDU,  "addu")                                                     \
+   X(DIV,   "div")                                                      \
+   X(MUL,   "mul")                                                      \
+   X(SUB,   "sub")                                                      \
+   X(SLT,   "slt")                /* d s t, d = 1 if s < t else 0      */ \
+   X(SLE,   "sle")                                                      \
+   X(SEQ,   "seq")                                                      \
+   X(ADDIU, "addiu")              /* d s i                             */ \
+   X(SLL,   "sll")                                                      \
+   X(XORI,  "xori")                                                     \
+   X(JALR,  "jalr")               /* s                                 */ \
+   X(JAL,   "jal")                /* A                                 */ \
+   X(JR,    "jr")                 /* s                                 */ \
+   X(B,     "b")                  /* A                                 */ \
+   X(BEQZ,  "beqz")               /* s A                               */ \
+   X(BEQ,   "beq")                /* s t A, or s i A if t is -1        */ \
+   X(BNE,   "bne")                                                      \
+   X(BLE,   "ble")                                                      \
+   X(BLT,   "blt")                                                      \
+   X(BGT,   "bgt")
+
+enum MipsOp {
+#define MIPS_ENUM(op, name) MIPS_##op,
+   MIPS_OPS(MIPS_ENUM)
+#undef MIPS_ENUM
+   MIPS_OP_COUNT
+};
+
+extern const char *mips_op_names[];
+extern const char *mips_reg_names[];
+
+#define MIPS_ZERO  0
+#define MIPS_SP   29
+#define MIPS_RA   31
+
+// The number of the register called `name'.
+int mips_reg(const char *name);
+
+enum MipsAddrKind {
+   ADDR_LABEL,                    // labeln, for n
+   ADDR_NAME,                     // name as it is
+   ADDR_PROTOBJ,                  // sym_protObj
+   ADDR_INIT,                     // sym_init
+   ADDR_METHOD,                   // cls.sym
+   ADDR_INT,                      // the Int constant sym
+   ADDR_STR,                      // the String constant sym
+   ADDR_BOOL                      // the Bool constant n
+};
+
+struct MipsAddr {
+   MipsAddrKind kind;
+   int n;
+   const char *name;
+   Symbol sym, cls;
+
+   MipsAddr(MipsAddrKind k = ADDR_NAME, int i = 0, const char *nm = NULL,
+            Symbol s = NULL, Symbol c = NULL) :
+      kind(k), n(i), name(nm), sym(s), cls(c) { }
+
+   static MipsAddr label(int l) { return MipsAddr(ADDR_LABEL, l); }
+   static MipsAddr named(const char *nm) { return MipsAddr(ADDR_NAME, 0, nm); }
+   static MipsAddr protobj(Symbol s) { return MipsAddr(ADDR_PROTOBJ, 0, NULL, s); }
+   static MipsAddr init(Symbol s) { return MipsAddr(ADDR_INIT, 0, NULL, s); }
+   static MipsAddr method(Symbol c, Symbol s) { return MipsAddr(ADDR_METHOD, 0, NULL, s, c); }
+   static MipsAddr int_const(Symbol s) { return MipsAddr(ADDR_INT, 0, NULL, s); }
+   static MipsAddr str_const(Symbol s) { return MipsAddr(ADDR_STR, 0, NULL, s); }
+   static MipsAddr bool_const(int b) { return MipsAddr(ADDR_BOOL, b); }
+
+   bool is_label(int l) const { return kind == ADDR_LABEL && n == l; }
+   void print(ostream& s) const;
+};
+
+struct MipsInsn {
+   MipsOp op;
+   int d, s, t;                   // registers, -1 if unused
+   int imm;
+   MipsAddr addr;
+
+   MipsInsn(MipsOp o, int rd = -1, int rs = -1, int rt = -1, int i = 0,
+            const MipsAddr& a = MipsAddr()) :
+      op(o), d(rd), s(rs), t(rt), imm(i), addr(a) { }
+
+   bool is_branch() const { return op >= MIPS_B; }
+   bool is_local_label() const { return op == MIPS_LABEL && addr.kind == ADDR_LABEL; }
+   void print(ostream& s) const;
+};
+
+struct MipsCode {
+   std::vector<MipsInsn> insns;
+
+   void add(const MipsInsn& in) { insns.push_back(in); }
+   int size() const;              // not counting labels
+   void print(ostream& s) const;
+};
+
+#endif
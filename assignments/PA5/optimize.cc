@@ -0,0 +1,1345 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  optimize.cc
+//
+//  The -O pipeline; see optimize.h.  In order:
+//
+//    to_ssa       pruned SSA: a phi wherever a register's definitions
+//                 meet and it is still live, then every definition
+//                 renamed down the dominator tree
+//    sccp         sparse conditional constant propagation (Wegman and
+//                 Zadeck); a branch on a constant loses its other side
+//    redundancy   a walk down the dominator tree doing value numbering
+//                 of the pure operations and copy propagation, reusing
+//                 attributes already loaded or stored on the way into
+//                 a block and dropping stores the next store overwrites
+//    unbox        Int and Bool arithmetic, comparisons and branches
+//                 work on numbers in registers; a value is boxed only
+//                 where it escapes, or where it is wanted after
+//                 something that may run the collector
+//    dce          what nothing uses and has no effect goes
+//    from_ssa     a phi whose registers never interfere becomes one
+//                 register; any other becomes copies at the ends of
+//                 its predecessors
+//    cleanup      blocks that only jump are bypassed, and a block with
+//                 one predecessor is merged into it
+//
+//  What COOL needs kept: a dispatch or case on void aborts, so calls
+//  and TAGs stay even when unused, and their void checks go only when
+//  the value cannot be void; division by zero and overflow trap, so
+//  neither is folded away; and initializers and methods may change any
+//  attribute of any object.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <assert.h>
+#include <map>
+#include <limits.h>
+#include <stdlib.h>
+#include "optimize.h"
+#include "regalloc.h"
+
+// An instruction a pass has removed, until compact() drops it.
+#define IR_GONE IR_OP_COUNT
+
+static bool is_pure(IrOp op)
+{
+   switch (op) {
+   case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_NEG:
+   case IR_LT: case IR_LE: case IR_EQ: case IR_EQUAL: case IR_NOT: case IR_ISVOID:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool is_commutative(IrOp op)
+{
+   return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_EQUAL;
+}
+
+//
+// The SCCP lattice: TOP (no value seen yet), a constant, or BOTTOM.
+//
+enum { TOP, CONST, BOTTOM };
+
+struct Lattice {
+   int level;
+   IrOp kind;                     // IR_INT, IR_STR, IR_BOOL or IR_VOID
+   int n;                         // of an Int or a Bool
+   Symbol sym;                    // of a String
+
+   Lattice(int l = TOP, IrOp k = IR_VOID, int v = 0, Symbol s = NULL) :
+      level(l), kind(k), n(v), sym(s) { }
+
+   bool operator==(const Lattice& o) const
+   {
+      return level == o.level &&
+         (level != CONST || (kind == o.kind && n == o.n && sym == o.sym));
+   }
+   bool operator!=(const Lattice& o) const { return !(*this == o); }
+};
+
+static Lattice meet(const Lattice& x, const Lattice& y)
+{
+   if (x.level == TOP) return y;
+   if (y.level == TOP) return x;
+   return x == y ? x : Lattice(BOTTOM);
+}
+
+//
+// Int arithmetic as the emitted code does it, unless that would trap.
+//
+static bool fold_int(IrOp op, int x, int y, int& r)
+{
+   long long v;
+   switch (op) {
+   case IR_ADD: v = (long long) x + y; break;
+   case IR_SUB: v = (long long) x - y; break;
+   case IR_MUL: v = (long long) x * y; break;
+   case IR_DIV:
+      if (y == 0) return false;
+      v = (long long) x / y;
+      break;
+   case IR_NEG: v = -(long long) x; break;
+   default: return false;
+   }
+   if (v < INT_MIN || v > INT_MAX) return false;
+   r = (int) v;
+   return true;
+}
+
+static Lattice fold(IrOp op, const Lattice& x, const Lattice& y)
+{
+   int r;
+   switch (op) {
+   case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_NEG:
+      if (fold_int(op, x.n, y.n, r)) return Lattice(CONST, IR_INT, r);
+      return Lattice(BOTTOM);
+   case IR_LT: return Lattice(CONST, IR_BOOL, x.n < y.n);
+   case IR_LE: return Lattice(CONST, IR_BOOL, x.n <= y.n);
+   case IR_EQ: return Lattice(CONST, IR_BOOL, x.n == y.n);
+   case IR_EQUAL:
+      // What equality_test does: void only equals void, and constants
+      // of different classes are never equal.
+      return Lattice(CONST, IR_BOOL, x.kind == y.kind && x.n == y.n && x.sym == y.sym);
+   case IR_NOT: return Lattice(CONST, IR_BOOL, !x.n);
+   case IR_ISVOID: return Lattice(CONST, IR_BOOL, x.kind == IR_VOID);
+   default: return Lattice(BOTTOM);
+   }
+}
+
+class Optimizer {
+private:
+   IrFunction& f;
+   std::vector<int> idom, postnum;             // by block; -1 if unreachable
+   std::vector<std::vector<int> > kids, frontier;
+
+   // sccp
+   std::vector<Lattice> value;
+   std::vector<std::vector<std::pair<int, int> > > users;
+   std::vector<std::vector<bool> > executable; // by block and predecessor
+   std::vector<bool> visited;
+   std::vector<std::pair<int, int> > edge_work;
+   std::vector<int> value_work;
+
+   // redundancy
+   typedef std::pair<int, std::pair<int, int> > Key;
+   std::map<Key, int> table;
+   std::vector<Key> table_log;
+   std::vector<int> rep;                       // value replaced by
+   std::vector<bool> nonvoid, checked;
+   std::vector<int> checked_log;
+
+   // unbox
+   std::vector<int> kind;                      // IR_INT or IR_BOOL, or -1
+   std::vector<bool> is_constant;
+   std::vector<int> constant;                  // an INT's or BOOL's number
+   std::vector<int> unboxed;                   // register with the number, or -1
+   std::vector<int> owner;                     // the value an unboxed register is
+   std::vector<bool> is_number;
+
+   int phis(int b);
+   void remove_edge(int b, int s);
+   void kill(int b);
+   void compact();
+   int find(int v) { while (rep[v] != v) v = rep[v]; return v; }
+   void rewrite(IrInsn& in);
+   void replace(IrInsn& in, int v) { rep[in.dst] = v; in.op = IR_GONE; }
+   bool known(int v) { return nonvoid[v] || checked[v]; }
+
+   void dominators();
+   int intersect(int x, int y);
+   void to_ssa();
+   void rename(int b, std::vector<std::vector<int> >& stack);
+   void sccp();
+   void visit(int b, int i);
+   void redundancy();
+   void number(int b, std::map<std::pair<int, int>, int> attrs);
+   void classify();
+   bool unboxable(const IrInsn& in);
+   int new_number(int v);
+   int number_of(int v, std::vector<IrInsn>& out);
+   int box_of(int v, std::vector<IrInsn>& out);
+   void unbox_with(const std::vector<bool>& keep);
+   void crossings(std::vector<int>& bad);
+   void loop_depths(std::vector<int>& depth);
+   void unbox();
+   void ssa_liveness(std::vector<std::vector<bool> >& live_in,
+                     std::vector<std::vector<bool> >& live_out);
+   void dce();
+   void from_ssa();
+   void cleanup();
+public:
+   Optimizer(IrFunction& fn) : f(fn) { }
+   void run();
+};
+
+//
+// The number of phis at the start of block b.
+//
+int Optimizer::phis(int b)
+{
+   std::vector<IrInsn>& insns = f.blocks[b].insns;
+   int n = 0;
+   while (n < (int) insns.size() && insns[n].op == IR_PHI) n++;
+   return n;
+}
+
+void Optimizer::remove_edge(int b, int s)
+{
+   std::vector<int>& succs = f.blocks[b].succs;
+   succs.erase(std::find(succs.begin(), succs.end(), s));
+   IrBlock& sb = f.blocks[s];
+   int j = std::find(sb.preds.begin(), sb.preds.end(), b) - sb.preds.begin();
+   sb.preds.erase(sb.preds.begin() + j);
+   for (int k = 0; k < phis(s); k++)
+      sb.insns[k].args.erase(sb.insns[k].args.begin() + j);
+}
+
+//
+// Empties a block nothing reaches.
+//
+void Optimizer::kill(int b)
+{
+   while (!f.blocks[b].succs.empty())
+      remove_edge(b, f.blocks[b].succs.back());
+   f.blocks[b].insns.clear();
+}
+
+void Optimizer::compact()
+{
+   for (size_t b = 0; b < f.blocks.size(); b++) {
+      std::vector<IrInsn>& insns = f.blocks[b].insns;
+      size_t k = 0;
+      for (size_t i = 0; i < insns.size(); i++)
+         if (insns[i].op != IR_GONE) {
+            if (k != i) insns[k] = insns[i];
+            k++;
+         }
+      insns.erase(insns.begin() + k, insns.end());
+   }
+}
+
+void Optimizer::rewrite(IrInsn& in)
+{
+   if (in.a >= 0) in.a = find(in.a);
+   if (in.b >= 0) in.b = find(in.b);
+   for (size_t k = 0; k < in.args.size(); k++) in.args[k] = find(in.args[k]);
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Dominators, by Cooper, Harvey and Kennedy's iteration over reverse
+// postorder, and dominance frontiers
+//
+///////////////////////////////////////////////////////////////////////
+
+int Optimizer::intersect(int x, int y)
+{
+   while (x != y) {
+      while (postnum[x] < postnum[y]) x = idom[x];
+      while (postnum[y] < postnum[x]) y = idom[y];
+   }
+   return x;
+}
+
+void Optimizer::dominators()
+{
+   int n = f.blocks.size();
+   postnum.assign(n, -1);
+   std::vector<int> post;
+   std::vector<bool> seen(n, false);
+   std::vector<std::pair<int, size_t> > stack(1, std::make_pair(0, (size_t) 0));
+   seen[0] = true;
+   while (!stack.empty()) {
+      int b = stack.back().first;
+      size_t& i = stack.back().second;
+      if (i < f.blocks[b].succs.size()) {
+         int s = f.blocks[b].succs[i++];
+         if (!seen[s]) {
+            seen[s] = true;
+            stack.push_back(std::make_pair(s, (size_t) 0));
+         }
+      } else {
+         postnum[b] = post.size();
+         post.push_back(b);
+         stack.pop_back();
+      }
+   }
+
+   idom.assign(n, -1);
+   idom[0] = 0;
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (int k = post.size() - 2; k >= 0; k--) {
+         int b = post[k], d = -1;
+         std::vector<int>& preds = f.blocks[b].preds;
+         for (size_t i = 0; i < preds.size(); i++)
+            if (idom[preds[i]] >= 0)
+               d = d < 0 ? preds[i] : intersect(preds[i], d);
+         if (idom[b] != d) {
+            idom[b] = d;
+            changed = true;
+         }
+      }
+   }
+
+   kids.assign(n, std::vector<int>());
+   frontier.assign(n, std::vector<int>());
+   for (int b = 1; b < n; b++) {
+      if (idom[b] < 0) continue;
+      kids[idom[b]].push_back(b);
+      std::vector<int>& preds = f.blocks[b].preds;
+      if (preds.size() < 2) continue;
+      for (size_t i = 0; i < preds.size(); i++)
+         for (int r = preds[i]; r != idom[b]; r = idom[r]) {
+            if (!frontier[r].empty() && frontier[r].back() == b) break;
+            frontier[r].push_back(b);
+         }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// SSA construction.  A phi remembers the register it was placed for
+// in imm until renaming has filled in its arguments.
+//
+///////////////////////////////////////////////////////////////////////
+
+void Optimizer::to_ssa()
+{
+   int nb = f.blocks.size(), nr = f.nregs;
+   std::vector<std::vector<bool> > live_in, live_out;
+   f.liveness(live_in, live_out);
+
+   // Lowering writes every register before reading it, but should one
+   // be read first, it is void there as a COOL variable would be.
+   std::vector<IrInsn>& entry = f.blocks[0].insns;
+   size_t at = 0;
+   while (at < entry.size() && entry[at].op == IR_PARAM) at++;
+   for (int r = 0; r < nr; r++)
+      if (live_in[0][r]) entry.insert(entry.begin() + at, IrInsn(IR_VOID, r));
+
+   std::vector<std::vector<int> > defs(nr);
+   for (int b = 0; b < nb; b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         int d = f.blocks[b].insns[i].dst;
+         if (d >= 0 && (defs[d].empty() || defs[d].back() != b)) defs[d].push_back(b);
+      }
+
+   std::vector<int> has_phi(nb, -1), queued(nb, -1);
+   for (int r = 0; r < nr; r++) {
+      std::vector<int> work = defs[r];
+      for (size_t i = 0; i < work.size(); i++) queued[work[i]] = r;
+      while (!work.empty()) {
+         int b = work.back();
+         work.pop_back();
+         for (size_t i = 0; i < frontier[b].size(); i++) {
+            int d = frontier[b][i];
+            if (has_phi[d] == r || !live_in[d][r]) continue;
+            IrInsn phi(IR_PHI, r);
+            phi.imm = r;
+            phi.args.assign(f.blocks[d].preds.size(), r);
+            f.blocks[d].insns.insert(f.blocks[d].insns.begin(), phi);
+            has_phi[d] = r;
+            if (queued[d] != r) {
+               queued[d] = r;
+               work.push_back(d);
+            }
+         }
+      }
+   }
+
+   std::vector<std::vector<int> > stack(nr);
+   f.nregs = 0;
+   rename(0, stack);
+}
+
+void Optimizer::rename(int b, std::vector<std::vector<int> >& stack)
+{
+   std::vector<int> pushed;
+   IrBlock& bl = f.blocks[b];
+   for (size_t i = 0; i < bl.insns.size(); i++) {
+      IrInsn& in = bl.insns[i];
+      if (in.op != IR_PHI) {
+         if (in.a >= 0) in.a = stack[in.a].back();
+         if (in.b >= 0) in.b = stack[in.b].back();
+         for (size_t k = 0; k < in.args.size(); k++) in.args[k] = stack[in.args[k]].back();
+      }
+      if (in.dst >= 0) {
+         stack[in.dst].push_back(f.nregs);
+         pushed.push_back(in.dst);
+         in.dst = f.nregs++;
+      }
+   }
+
+   for (size_t i = 0; i < bl.succs.size(); i++) {
+      int s = bl.succs[i];
+      if (std::find(bl.succs.begin(), bl.succs.begin() + i, s) != bl.succs.begin() + i) continue;
+      IrBlock& sb = f.blocks[s];
+      for (size_t j = 0; j < sb.preds.size(); j++)
+         if (sb.preds[j] == b)
+            for (int k = 0; k < phis(s); k++)
+               sb.insns[k].args[j] = stack[sb.insns[k].imm].back();
+   }
+
+   for (size_t i = 0; i < kids[b].size(); i++) rename(kids[b][i], stack);
+   for (size_t i = 0; i < pushed.size(); i++) stack[pushed[i]].pop_back();
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Sparse conditional constant propagation
+//
+///////////////////////////////////////////////////////////////////////
+
+//
+// Evaluates instruction i of block b, which has been reached, again.
+//
+void Optimizer::visit(int b, int i)
+{
+   IrBlock& bl = f.blocks[b];
+   IrInsn& in = bl.insns[i];
+   Lattice v(BOTTOM);
+
+   switch (in.op) {
+   case IR_JMP:
+      edge_work.push_back(std::make_pair(b, bl.succs[0]));
+      return;
+   case IR_BR:
+      if (value[in.a].level == CONST)
+         edge_work.push_back(std::make_pair(b, bl.succs[value[in.a].n ? 0 : 1]));
+      else if (value[in.a].level == BOTTOM) {
+         edge_work.push_back(std::make_pair(b, bl.succs[0]));
+         edge_work.push_back(std::make_pair(b, bl.succs[1]));
+      }
+      return;
+   case IR_BRRANGE:
+      edge_work.push_back(std::make_pair(b, bl.succs[0]));
+      edge_work.push_back(std::make_pair(b, bl.succs[1]));
+      return;
+   case IR_RET: case IR_CASEABORT: case IR_SETATTR: case IR_INIT:
+      return;
+   case IR_PHI:
+      v = Lattice(TOP);
+      for (size_t j = 0; j < in.args.size(); j++)
+         if (executable[b][j]) v = meet(v, value[in.args[j]]);
+      break;
+   case IR_INT:
+      v = Lattice(CONST, IR_INT, atoi(in.sym->get_string()));
+      break;
+   case IR_STR:
+      v = Lattice(CONST, IR_STR, 0, in.sym);
+      break;
+   case IR_BOOL:
+      v = Lattice(CONST, IR_BOOL, in.imm);
+      break;
+   case IR_VOID:
+      v = Lattice(CONST, IR_VOID);
+      break;
+   case IR_MOVE:
+      v = value[in.a];
+      break;
+   default:
+      if (is_pure(in.op)) {
+         Lattice x = value[in.a], y = in.b >= 0 ? value[in.b] : Lattice(CONST);
+         if (x.level == BOTTOM || y.level == BOTTOM)
+            v = Lattice(BOTTOM);
+         else if (x.level == TOP || y.level == TOP)
+            v = Lattice(TOP);
+         else
+            v = fold(in.op, x, y);
+      }
+      break;
+   }
+
+   if (in.dst >= 0 && value[in.dst] != v) {
+      value[in.dst] = v;
+      value_work.push_back(in.dst);
+   }
+}
+
+void Optimizer::sccp()
+{
+   int nb = f.blocks.size();
+   value.assign(f.nregs, Lattice());
+   users.assign(f.nregs, std::vector<std::pair<int, int> >());
+   executable.assign(nb, std::vector<bool>());
+   visited.assign(nb, false);
+   std::vector<int> uses;
+   for (int b = 0; b < nb; b++) {
+      executable[b].assign(f.blocks[b].preds.size(), false);
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         f.blocks[b].insns[i].uses(uses);
+         for (size_t k = 0; k < uses.size(); k++)
+            users[uses[k]].push_back(std::make_pair(b, (int) i));
+      }
+   }
+
+   visited[0] = true;
+   for (size_t i = 0; i < f.blocks[0].insns.size(); i++) visit(0, i);
+   while (!edge_work.empty() || !value_work.empty()) {
+      if (!edge_work.empty()) {
+         int p = edge_work.back().first, s = edge_work.back().second;
+         edge_work.pop_back();
+         bool fresh = false;
+         for (size_t j = 0; j < f.blocks[s].preds.size(); j++)
+            if (f.blocks[s].preds[j] == p && !executable[s][j])
+               executable[s][j] = fresh = true;
+         if (!fresh) continue;
+         int from = visited[s] ? 0 : f.blocks[s].insns.size();
+         visited[s] = true;
+         for (int i = 0; i < std::max(phis(s), from); i++) visit(s, i);
+      } else {
+         int v = value_work.back();
+         value_work.pop_back();
+         for (size_t k = 0; k < users[v].size(); k++)
+            if (visited[users[v][k].first]) visit(users[v][k].first, users[v][k].second);
+      }
+   }
+
+   // Constants replace what computed them; a phi that became one goes
+   // after the remaining phis.
+   std::vector<std::pair<int, int> > dead_edges;
+   for (int b = 0; b < nb; b++) {
+      if (!visited[b]) continue;
+      std::vector<IrInsn>& insns = f.blocks[b].insns;
+      std::vector<IrInsn> done, moved;
+      int np = phis(b);
+      for (int i = 0; i < (int) insns.size(); i++) {
+         if (i == np) done.insert(done.end(), moved.begin(), moved.end());
+         IrInsn in = insns[i];
+         if (in.dst >= 0 && value[in.dst].level == CONST && in.op != value[in.dst].kind) {
+            Lattice& v = value[in.dst];
+            IrInsn c(v.kind, in.dst);
+            c.line = in.line;
+            if (v.kind == IR_INT) c.sym = inttable.add_int(v.n);
+            else if (v.kind == IR_STR) c.sym = v.sym;
+            else if (v.kind == IR_BOOL) c.imm = v.n;
+            if (in.op == IR_PHI) {
+               moved.push_back(c);
+               continue;
+            }
+            in = c;
+         }
+         done.push_back(in);
+      }
+      insns.swap(done);
+
+      std::vector<int>& succs = f.blocks[b].succs;
+      for (size_t i = 0; i < succs.size(); i++) {
+         int s = succs[i];
+         bool live = false;
+         for (size_t j = 0; j < f.blocks[s].preds.size(); j++)
+            if (f.blocks[s].preds[j] == b && executable[s][j]) live = true;
+         if (!live) dead_edges.push_back(std::make_pair(b, s));
+      }
+   }
+   for (size_t i = 0; i < dead_edges.size(); i++) {
+      int b = dead_edges[i].first;
+      remove_edge(b, dead_edges[i].second);
+      IrInsn& t = f.blocks[b].terminator();
+      if (t.op == IR_BR && f.blocks[b].succs.size() == 1) {
+         t.op = IR_JMP;
+         t.a = -1;
+      }
+   }
+   for (int b = 0; b < nb; b++)
+      if (!visited[b]) kill(b);
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Redundancy elimination, down the dominator tree.  A value used as a
+// receiver or cased on is not void in what that use dominates: had it
+// been, the program would have stopped there.
+//
+///////////////////////////////////////////////////////////////////////
+
+void Optimizer::redundancy()
+{
+   rep.resize(f.nregs);
+   for (int v = 0; v < f.nregs; v++) rep[v] = v;
+   nonvoid.assign(f.nregs, false);
+   checked.assign(f.nregs, false);
+   number(0, std::map<std::pair<int, int>, int>());
+
+   // Back edges were not seen on the way down, so phis there may only
+   // now turn out to copy one value.
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (size_t b = 0; b < f.blocks.size(); b++)
+         for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+            IrInsn& in = f.blocks[b].insns[i];
+            if (in.op == IR_GONE) continue;
+            rewrite(in);
+            if (in.op != IR_PHI) continue;
+            int v = -1;
+            bool same = true;
+            for (size_t k = 0; k < in.args.size(); k++)
+               if (in.args[k] != in.dst && in.args[k] != v) {
+                  same = v < 0;
+                  v = in.args[k];
+               }
+            if (same && v >= 0) {
+               replace(in, v);
+               changed = true;
+            }
+         }
+   }
+   compact();
+}
+
+//
+// attrs maps (object, attribute) to the value the attribute is known
+// to hold; a block gets its predecessor's if it is the only one.
+//
+void Optimizer::number(int b, std::map<std::pair<int, int>, int> attrs)
+{
+   size_t table_mark = table_log.size(), checked_mark = checked_log.size();
+   std::map<std::pair<int, int>, int> stores;     // to a store nothing read yet
+
+   IrBlock& bl = f.blocks[b];
+   for (size_t i = 0; i < bl.insns.size(); i++) {
+      IrInsn& in = bl.insns[i];
+      rewrite(in);
+
+      switch (in.op) {
+      case IR_PHI: {
+         int v = -1;
+         bool same = true, nv = true;
+         for (size_t k = 0; k < in.args.size(); k++) {
+            int a = in.args[k];
+            if (a == in.dst) continue;
+            if (v >= 0 && a != v) same = false;
+            v = a;
+            nv = nv && nonvoid[a];
+         }
+         if (same && v >= 0)
+            replace(in, v);
+         else
+            nonvoid[in.dst] = nv;
+         break;
+      }
+      case IR_MOVE:
+         replace(in, in.a);
+         break;
+      case IR_PARAM:
+         nonvoid[in.dst] = in.imm == 0;
+         break;
+      case IR_INT: case IR_STR: case IR_BOOL:
+         nonvoid[in.dst] = true;
+         break;
+      case IR_NEW: case IR_NEWSELF:
+         nonvoid[in.dst] = true;
+         attrs.clear();
+         stores.clear();
+         break;
+      case IR_INIT:
+         attrs.clear();
+         stores.clear();
+         break;
+      case IR_CALL: case IR_SCALL: case IR_CHECK: case IR_TAG:
+         in.nonvoid = known(in.a);
+         if (!checked[in.a]) {
+            checked[in.a] = true;
+            checked_log.push_back(in.a);
+         }
+         if (in.is_call()) {
+            attrs.clear();
+            stores.clear();
+         }
+         break;
+      case IR_GETATTR: {
+         std::pair<int, int> k(in.a, in.imm);
+         if (attrs.count(k))
+            replace(in, attrs[k]);
+         else
+            attrs[k] = in.dst;
+         for (std::map<std::pair<int, int>, int>::iterator s = stores.begin(); s != stores.end(); )
+            if (s->first.second == in.imm) stores.erase(s++); else ++s;
+         break;
+      }
+      case IR_SETATTR: {
+         std::pair<int, int> k(in.a, in.imm);
+         if (stores.count(k)) bl.insns[stores[k]].op = IR_GONE;
+         for (std::map<std::pair<int, int>, int>::iterator s = attrs.begin(); s != attrs.end(); )
+            if (s->first.second == in.imm && s->first.first != in.a) attrs.erase(s++); else ++s;
+         attrs[k] = in.b;
+         stores[k] = i;
+         break;
+      }
+      default:
+         if (!is_pure(in.op)) break;
+         nonvoid[in.dst] = true;
+         if (in.op == IR_ISVOID && known(in.a)) {
+            in.op = IR_BOOL;
+            in.a = -1;
+            in.imm = 0;
+            break;
+         }
+         if ((in.op == IR_EQ || in.op == IR_LE || in.op == IR_EQUAL || in.op == IR_LT)
+             && in.a == in.b) {
+            in.imm = in.op != IR_LT;
+            in.op = IR_BOOL;
+            in.a = in.b = -1;
+            break;
+         }
+         if (is_commutative(in.op) && in.a > in.b) std::swap(in.a, in.b);
+         Key k(in.op, std::make_pair(in.a, in.b));
+         std::map<Key, int>::iterator t = table.find(k);
+         if (t != table.end())
+            replace(in, t->second);
+         else {
+            table[k] = in.dst;
+            table_log.push_back(k);
+         }
+         break;
+      }
+   }
+
+   for (size_t i = 0; i < kids[b].size(); i++) {
+      int k = kids[b][i];
+      number(k, f.blocks[k].preds.size() == 1 ? attrs : std::map<std::pair<int, int>, int>());
+   }
+
+   while (table_log.size() > table_mark) {
+      table.erase(table_log.back());
+      table_log.pop_back();
+   }
+   while (checked_log.size() > checked_mark) {
+      checked[checked_log.back()] = false;
+      checked_log.pop_back();
+   }
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Unboxing.  Every Int and Bool operation computes a number, from the
+// numbers of its operands: one unboxed value already has, an IMM for
+// a constant, or an UNBOX just before the use.  A value kept unboxed
+// lives on as that number, and is boxed again just before each use
+// that wants an object: an attribute, an argument or receiver, a
+// return, a case, or a phi that is not unboxed itself.  Any other value
+// is boxed as soon as it is computed, as before.
+//
+// The collector takes what it finds in the frame and in $s1-$s6 for
+// pointers, so no number may be live across anything that can run it
+// (regalloc.h's calls_out, which takes in BOX).  Values whose numbers
+// would be are boxed where they are computed instead, and the rewrite
+// starts again until none is.  Unboxing a value that escapes more than
+// once would box it more than once, so those are not tried.
+//
+///////////////////////////////////////////////////////////////////////
+
+#define UNKNOWN -2
+
+static IrOp number_op(IrOp op)
+{
+   switch (op) {
+   case IR_ADD: return IR_RADD;
+   case IR_SUB: return IR_RSUB;
+   case IR_MUL: return IR_RMUL;
+   case IR_DIV: return IR_RDIV;
+   case IR_NEG: return IR_RNEG;
+   case IR_LT: return IR_RLT;
+   case IR_LE: return IR_RLE;
+   case IR_EQ: case IR_EQUAL: return IR_REQ;
+   case IR_NOT: return IR_RNOT;
+   default: return IR_OP_COUNT;
+   }
+}
+
+//
+// What each value is known to hold.  A phi holds an Int or a Bool if
+// everything it merges does.
+//
+void Optimizer::classify()
+{
+   int n = f.nregs;
+   kind.assign(n, -1);
+   is_constant.assign(n, false);
+   constant.assign(n, 0);
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         switch (in.op) {
+         case IR_INT:
+            kind[in.dst] = IR_INT;
+            is_constant[in.dst] = true;
+            constant[in.dst] = atoi(in.sym->get_string());
+            break;
+         case IR_BOOL:
+            kind[in.dst] = IR_BOOL;
+            is_constant[in.dst] = true;
+            constant[in.dst] = in.imm;
+            break;
+         case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_NEG:
+            kind[in.dst] = IR_INT;
+            break;
+         case IR_LT: case IR_LE: case IR_EQ: case IR_EQUAL: case IR_NOT: case IR_ISVOID:
+            kind[in.dst] = IR_BOOL;
+            break;
+         case IR_PHI:
+            kind[in.dst] = UNKNOWN;
+            break;
+         default:
+            break;
+         }
+      }
+
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (size_t b = 0; b < f.blocks.size(); b++)
+         for (int i = 0; i < phis(b); i++) {
+            IrInsn& in = f.blocks[b].insns[i];
+            if (kind[in.dst] == -1) continue;
+            int k = UNKNOWN;
+            for (size_t j = 0; j < in.args.size(); j++) {
+               int a = kind[in.args[j]];
+               if (a == UNKNOWN) continue;
+               k = k == UNKNOWN || k == a ? a : -1;
+            }
+            if (k != kind[in.dst]) {
+               kind[in.dst] = k;
+               changed = true;
+            }
+         }
+   }
+   for (int v = 0; v < n; v++)
+      if (kind[v] == UNKNOWN) kind[v] = -1;
+}
+
+//
+// Whether `in' can compute a number from numbers.  Objects compared
+// with = are only both Ints or both Bools if both are known to be.
+//
+bool Optimizer::unboxable(const IrInsn& in)
+{
+   if (number_op(in.op) == IR_OP_COUNT) return false;
+   return in.op != IR_EQUAL || (kind[in.a] >= 0 && kind[in.a] == kind[in.b]);
+}
+
+int Optimizer::new_number(int v)
+{
+   int r = f.new_reg();
+   is_number.push_back(true);
+   owner.push_back(v);
+   return r;
+}
+
+//
+// The number of `v', computed at the end of `out' if need be.
+//
+int Optimizer::number_of(int v, std::vector<IrInsn>& out)
+{
+   if (unboxed[v] >= 0) return unboxed[v];
+   int t = new_number(-1);
+   if (is_constant[v]) {
+      IrInsn c(IR_IMM, t);
+      c.imm = constant[v];
+      out.push_back(c);
+   } else
+      out.push_back(IrInsn(IR_UNBOX, t, v));
+   return t;
+}
+
+//
+// `v' as an object, boxed at the end of `out' if need be.
+//
+int Optimizer::box_of(int v, std::vector<IrInsn>& out)
+{
+   if (unboxed[v] < 0) return v;
+   int t = f.new_reg();
+   is_number.push_back(false);
+   owner.push_back(-1);
+   out.push_back(IrInsn(kind[v] == IR_INT ? IR_BOX : IR_BOXBOOL, t, unboxed[v]));
+   return t;
+}
+
+void Optimizer::unbox_with(const std::vector<bool>& keep)
+{
+   int n = f.nregs, nb = f.blocks.size();
+   is_number.assign(n, false);
+   owner.assign(n, -1);
+   unboxed.assign(n, -1);
+   for (int v = 0; v < n; v++)
+      if (keep[v]) unboxed[v] = new_number(v);
+
+   // What goes at the end of each block, before its terminator: boxes
+   // first, so that no number waits across one.
+   std::vector<std::vector<IrInsn> > body(nb), boxes(nb), numbers(nb), before(nb);
+   for (int b = 0; b < nb; b++) {
+      std::vector<IrInsn>& insns = f.blocks[b].insns;
+      if (insns.empty()) continue;
+      std::vector<int>& preds = f.blocks[b].preds;
+      for (size_t i = 0; i + 1 < insns.size(); i++) {
+         IrInsn in = insns[i];
+         if (in.op == IR_PHI) {
+            for (size_t j = 0; j < in.args.size(); j++)
+               in.args[j] = keep[in.dst] ? number_of(in.args[j], numbers[preds[j]])
+                                         : box_of(in.args[j], boxes[preds[j]]);
+            if (keep[in.dst]) in.dst = unboxed[in.dst];
+            body[b].push_back(in);
+         } else if (unboxable(in)) {
+            IrInsn r(number_op(in.op), keep[in.dst] ? unboxed[in.dst] : new_number(-1));
+            r.a = number_of(in.a, body[b]);
+            if (in.b >= 0) r.b = number_of(in.b, body[b]);
+            r.line = in.line;
+            body[b].push_back(r);
+            if (!keep[in.dst])
+               body[b].push_back(IrInsn(kind[in.dst] == IR_INT ? IR_BOX : IR_BOXBOOL,
+                                        in.dst, r.dst));
+         } else {
+            if (in.a >= 0) in.a = box_of(in.a, body[b]);
+            if (in.b >= 0) in.b = box_of(in.b, body[b]);
+            for (size_t k = 0; k < in.args.size(); k++) in.args[k] = box_of(in.args[k], body[b]);
+            body[b].push_back(in);
+         }
+      }
+      IrInsn t = insns.back();
+      if (t.op == IR_BR)
+         t.a = number_of(t.a, before[b]);
+      else if (t.a >= 0)
+         t.a = box_of(t.a, before[b]);
+      before[b].push_back(t);
+   }
+
+   for (int b = 0; b < nb; b++) {
+      std::vector<IrInsn>& insns = f.blocks[b].insns;
+      if (insns.empty()) continue;
+      insns.swap(body[b]);
+      insns.insert(insns.end(), boxes[b].begin(), boxes[b].end());
+      insns.insert(insns.end(), numbers[b].begin(), numbers[b].end());
+      insns.insert(insns.end(), before[b].begin(), before[b].end());
+   }
+}
+
+//
+// The values whose numbers are live across a call.
+//
+void Optimizer::crossings(std::vector<int>& bad)
+{
+   std::vector<std::vector<bool> > live_in, live_out;
+   ssa_liveness(live_in, live_out);
+   std::vector<int> uses;
+   for (size_t b = 0; b < f.blocks.size(); b++) {
+      IrBlock& bl = f.blocks[b];
+      std::vector<bool> live = live_out[b];
+      for (int i = bl.insns.size() - 1; i >= phis(b); i--) {
+         IrInsn& in = bl.insns[i];
+         if (calls_out(in))
+            for (int r = 0; r < f.nregs; r++)
+               if (live[r] && is_number[r] && r != in.dst) {
+                  assert(owner[r] >= 0);
+                  bad.push_back(owner[r]);
+               }
+         if (in.dst >= 0) live[in.dst] = false;
+         in.uses(uses);
+         for (size_t k = 0; k < uses.size(); k++) live[uses[k]] = true;
+      }
+   }
+}
+
+//
+// How many loops each block is in.  A loop is everything that reaches
+// the source of an edge back to a block that dominates it, without
+// passing through that block.
+//
+void Optimizer::loop_depths(std::vector<int>& depth)
+{
+   int nb = f.blocks.size();
+   depth.assign(nb, 0);
+   for (int h = 0; h < nb; h++) {
+      std::vector<bool> in(nb, false);
+      std::vector<int> work;
+      for (size_t j = 0; j < f.blocks[h].preds.size(); j++) {
+         int p = f.blocks[h].preds[j], d = p;
+         while (d != h && d > 0 && idom[d] >= 0) d = idom[d];
+         if (d == h) work.push_back(p);
+      }
+      if (work.empty()) continue;
+      in[h] = true;
+      while (!work.empty()) {
+         int b = work.back();
+         work.pop_back();
+         if (in[b]) continue;
+         in[b] = true;
+         for (size_t j = 0; j < f.blocks[b].preds.size(); j++) work.push_back(f.blocks[b].preds[j]);
+      }
+      for (int b = 0; b < nb; b++)
+         if (in[b]) depth[b]++;
+   }
+}
+
+void Optimizer::unbox()
+{
+   classify();
+   int n = f.nregs;
+
+   // An escape in a loop the value is not computed in is taken to be
+   // more than one.
+   std::vector<int> depth, home(n, 0), escapes(n, 0), uses;
+   loop_depths(depth);
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++)
+         if (f.blocks[b].insns[i].dst >= 0) home[f.blocks[b].insns[i].dst] = b;
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.op == IR_PHI || in.op == IR_BR || unboxable(in)) continue;
+         in.uses(uses);
+         for (size_t k = 0; k < uses.size(); k++)
+            escapes[uses[k]] += depth[b] > depth[home[uses[k]]] ? 2 : 1;
+      }
+
+   std::vector<bool> keep(n, false);
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.dst >= 0 && kind[in.dst] >= 0 && escapes[in.dst] <= 1
+             && (in.op == IR_PHI || unboxable(in)))
+            keep[in.dst] = true;
+      }
+
+   // A phi merging a boxed value would box it again, and one merging
+   // only constants would box what was static, where nothing was
+   // allocated before.
+   std::vector<IrBlock> original = f.blocks;
+   for (;;) {
+      for (bool changed = true; changed; ) {
+         changed = false;
+         for (size_t b = 0; b < f.blocks.size(); b++)
+            for (int i = 0; i < phis(b); i++) {
+               IrInsn& in = f.blocks[b].insns[i];
+               if (!keep[in.dst]) continue;
+               bool computed = false, boxed = false;
+               for (size_t j = 0; j < in.args.size(); j++) {
+                  int a = in.args[j];
+                  if (keep[a] && a != in.dst) computed = true;
+                  if (!keep[a] && !is_constant[a]) boxed = true;
+               }
+               if (boxed || !computed) {
+                  keep[in.dst] = false;
+                  changed = true;
+               }
+            }
+      }
+      unbox_with(keep);
+      std::vector<int> bad;
+      crossings(bad);
+      if (bad.empty()) break;
+      for (size_t i = 0; i < bad.size(); i++) keep[bad[i]] = false;
+      f.blocks = original;
+      f.nregs = n;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Dead code elimination, from what has an effect back through what it
+// uses
+//
+///////////////////////////////////////////////////////////////////////
+
+//
+// Whether `in' must stay even if nothing uses its value.
+//
+static bool has_effect(const IrInsn& in, const std::vector<IrInsn *>& def)
+{
+   switch (in.op) {
+   case IR_SETATTR: case IR_NEW: case IR_NEWSELF: case IR_INIT:
+   case IR_CALL: case IR_SCALL:
+      return true;
+   case IR_DIV:
+      return def[in.b] == NULL || def[in.b]->op != IR_INT
+         || atoi(def[in.b]->sym->get_string()) == 0;
+   case IR_RDIV:
+      return def[in.b] == NULL || def[in.b]->op != IR_IMM || def[in.b]->imm == 0;
+   case IR_TAG: case IR_CHECK:
+      return !in.nonvoid;
+   default:
+      return in.is_terminator();
+   }
+}
+
+void Optimizer::dce()
+{
+   std::vector<IrInsn *> def(f.nregs, (IrInsn *) NULL);
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.dst >= 0) def[in.dst] = &in;
+      }
+
+   std::vector<bool> used(f.nregs, false);
+   std::vector<int> work, uses;
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (!has_effect(in, def)) continue;
+         in.uses(uses);
+         work.insert(work.end(), uses.begin(), uses.end());
+      }
+   while (!work.empty()) {
+      int v = work.back();
+      work.pop_back();
+      if (used[v]) continue;
+      used[v] = true;
+      if (def[v] == NULL) continue;
+      def[v]->uses(uses);
+      work.insert(work.end(), uses.begin(), uses.end());
+   }
+
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.dst >= 0 && !used[in.dst] && !has_effect(in, def)) in.op = IR_GONE;
+      }
+   compact();
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Out of SSA.  Values interfere if one is live where the other is
+// defined; a phi's argument is live at the end of its predecessor, not
+// at the start of the phi's block.  Coalescing is all or nothing for
+// each phi.  One that cannot be coalesced gets a fresh register t:
+// each predecessor ends by copying its argument to t, and the phi
+// becomes a copy from t (Sreedhar's method I), which is right however
+// the other registers were coalesced.
+//
+///////////////////////////////////////////////////////////////////////
+
+//
+// Liveness in SSA form: a phi's argument is live at the end of its
+// predecessor, not at the start of the phi's block.
+//
+void Optimizer::ssa_liveness(std::vector<std::vector<bool> >& live_in,
+                             std::vector<std::vector<bool> >& live_out)
+{
+   int n = f.nregs, nb = f.blocks.size();
+   live_in.assign(nb, std::vector<bool>(n, false));
+   live_out = live_in;
+   std::vector<int> uses;
+   for (bool changed = true; changed; ) {
+      changed = false;
+      for (int b = nb - 1; b >= 0; b--) {
+         IrBlock& bl = f.blocks[b];
+         std::vector<bool> live(n, false);
+         for (size_t i = 0; i < bl.succs.size(); i++) {
+            int s = bl.succs[i];
+            for (int r = 0; r < n; r++)
+               if (live_in[s][r]) live[r] = true;
+            for (size_t j = 0; j < f.blocks[s].preds.size(); j++)
+               if (f.blocks[s].preds[j] == b)
+                  for (int k = 0; k < phis(s); k++) live[f.blocks[s].insns[k].args[j]] = true;
+         }
+         live_out[b] = live;
+         for (int i = bl.insns.size() - 1; i >= phis(b); i--) {
+            IrInsn& in = bl.insns[i];
+            if (in.dst >= 0) live[in.dst] = false;
+            in.uses(uses);
+            for (size_t k = 0; k < uses.size(); k++) live[uses[k]] = true;
+         }
+         for (int k = 0; k < phis(b); k++) live[bl.insns[k].dst] = false;
+         if (live != live_in[b]) {
+            live_in[b].swap(live);
+            changed = true;
+         }
+      }
+   }
+}
+
+void Optimizer::from_ssa()
+{
+   int n = f.nregs, nb = f.blocks.size();
+   std::vector<std::vector<bool> > live_in, live_out;
+   ssa_liveness(live_in, live_out);
+
+   std::vector<int> uses;
+   std::vector<std::vector<bool> > clash(n, std::vector<bool>(n, false));
+   for (int b = 0; b < nb; b++) {
+      IrBlock& bl = f.blocks[b];
+      std::vector<bool> live = live_out[b];
+      int np = phis(b);
+      for (int i = bl.insns.size() - 1; i >= 0; i--) {
+         IrInsn& in = bl.insns[i];
+         if (in.dst >= 0) {
+            for (int r = 0; r < n; r++)
+               if (live[r] && r != in.dst) clash[r][in.dst] = clash[in.dst][r] = true;
+            if (i < np)
+               for (int k = 0; k < np; k++)
+                  if (bl.insns[k].dst != in.dst)
+                     clash[bl.insns[k].dst][in.dst] = clash[in.dst][bl.insns[k].dst] = true;
+            if (i >= np) live[in.dst] = false;
+         }
+         if (i >= np) {
+            in.uses(uses);
+            for (size_t k = 0; k < uses.size(); k++) live[uses[k]] = true;
+         }
+      }
+   }
+
+   std::vector<int> leader(n);
+   std::vector<std::vector<int> > members(n);
+   for (int v = 0; v < n; v++) {
+      leader[v] = v;
+      members[v].push_back(v);
+   }
+   int self = -1;
+   std::vector<IrInsn>& entry = f.blocks[0].insns;
+   if (!entry.empty() && entry[0].op == IR_PARAM && entry[0].imm == 0) self = entry[0].dst;
+
+   std::vector<std::pair<int, IrInsn> > copies;
+   for (int b = 0; b < nb; b++) {
+      int np = phis(b);
+      for (int k = 0; k < np; k++) {
+         IrInsn& phi = f.blocks[b].insns[k];
+         std::vector<int> group(1, leader[phi.dst]);
+         bool ok = true;
+         for (size_t j = 0; j < phi.args.size() && ok; j++) {
+            int c = leader[phi.args[j]];
+            if (std::find(group.begin(), group.end(), c) != group.end()) continue;
+            for (size_t g = 0; g < group.size() && ok; g++)
+               for (size_t x = 0; x < members[c].size() && ok; x++)
+                  for (size_t y = 0; y < members[group[g]].size() && ok; y++)
+                     ok = !clash[members[c][x]][members[group[g]][y]];
+            group.push_back(c);
+         }
+         for (size_t g = 0; g < group.size() && ok; g++)
+            ok = self < 0 || leader[self] != group[g];
+
+         if (ok) {
+            for (size_t g = 1; g < group.size(); g++) {
+               for (size_t x = 0; x < members[group[g]].size(); x++) {
+                  leader[members[group[g]][x]] = group[0];
+                  members[group[0]].push_back(members[group[g]][x]);
+               }
+               members[group[g]].clear();
+            }
+            phi.op = IR_GONE;
+            continue;
+         }
+
+         int t = f.nregs++;
+         leader.push_back(t);
+         members.push_back(std::vector<int>(1, t));
+         for (size_t j = 0; j < phi.args.size(); j++) {
+            IrInsn copy(IR_MOVE, t, phi.args[j]);
+            copy.line = phi.line;
+            copies.push_back(std::make_pair(f.blocks[b].preds[j], copy));
+         }
+         phi.op = IR_MOVE;
+         phi.a = t;
+         phi.args.clear();
+      }
+   }
+   for (size_t i = 0; i < copies.size(); i++) {
+      std::vector<IrInsn>& insns = f.blocks[copies[i].first].insns;
+      insns.insert(insns.end() - 1, copies[i].second);
+   }
+
+   std::vector<int> number(f.nregs, -1);
+   int count = 0;
+   for (int b = 0; b < nb; b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.op == IR_GONE) continue;
+         int *regs[] = { &in.dst, &in.a, &in.b };
+         for (int k = 0; k < 3 + (int) in.args.size(); k++) {
+            int& r = k < 3 ? *regs[k] : in.args[k - 3];
+            if (r < 0) continue;
+            if (number[leader[r]] < 0) number[leader[r]] = count++;
+            r = number[leader[r]];
+         }
+         if (in.op == IR_MOVE && in.dst == in.a) in.op = IR_GONE;
+      }
+   f.nregs = count;
+   compact();
+}
+
+///////////////////////////////////////////////////////////////////////
+//
+// Control flow cleanup
+//
+///////////////////////////////////////////////////////////////////////
+
+void Optimizer::cleanup()
+{
+   int nb = f.blocks.size();
+   std::vector<int> target(nb);
+   for (int b = 0; b < nb; b++) {
+      IrBlock& bl = f.blocks[b];
+      target[b] = b > 0 && bl.insns.size() == 1 && bl.insns[0].op == IR_JMP ? bl.succs[0] : b;
+   }
+   for (int b = 0; b < nb; b++) {
+      IrBlock& bl = f.blocks[b];
+      for (size_t i = 0; i < bl.succs.size(); i++) {
+         int s = bl.succs[i];
+         for (int steps = 0; target[s] != s && steps < nb; steps++) s = target[s];
+         bl.succs[i] = s;
+      }
+      if (!bl.insns.empty() && bl.terminator().op == IR_BR && bl.succs[0] == bl.succs[1]) {
+         bl.terminator().op = IR_JMP;
+         bl.terminator().a = -1;
+         bl.succs.pop_back();
+      }
+   }
+   f.build_cfg();
+
+   for (size_t b = 0; b < f.blocks.size(); b++) {
+      IrBlock& bl = f.blocks[b];
+      while (bl.succs.size() == 1 && bl.terminator().op == IR_JMP) {
+         int s = bl.succs[0];
+         IrBlock& sb = f.blocks[s];
+         if (s == (int) b || s == 0 || sb.preds.size() != 1 || sb.insns.empty()) break;
+         bl.insns.pop_back();
+         bl.insns.insert(bl.insns.end(), sb.insns.begin(), sb.insns.end());
+         bl.succs = sb.succs;
+         sb.insns.clear();
+         sb.succs.clear();
+      }
+   }
+   f.build_cfg();
+}
+
+void Optimizer::run()
+{
+   dominators();
+   to_ssa();
+   sccp();
+   dominators();
+   redundancy();
+   unbox();
+   dce();
+   from_ssa();
+   cleanup();
+}
+
+void optimize(IrFunction& f)
+{
+   Optimizer(f).run();
+}
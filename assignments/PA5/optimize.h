@@ -0,0 +1,23 @@
+#ifndef OPTIMIZE_H_
+#define OPTIMIZE_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  optimize.h
+//
+//  What cgen -O does to an IrFunction after lowering.  The function is
+//  put in SSA form, improved by sparse conditional constant
+//  propagation, value numbering, copy propagation, unboxing and dead
+//  code elimination, and taken out of SSA again, so that what comes
+//  back is ordinary IR that register allocation and FunctionCoder take
+//  as it is.  A folded value becomes a constant from inttable or a Bool
+//  constant; Int and Bool arithmetic works on numbers, which are boxed
+//  only where they escape (see ir.h).
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "ir.h"
+
+void optimize(IrFunction& f);
+
+#endif
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  outbuf.cc
+//
+//  Buffered output sink for the code generator and the AST dumpers.
+//  See outbuf.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include "outbuf.h"
+
+OutBuf::OutBuf(int f) : fd(f), owns_fd(false)
+{
+   buf = new char[OUTBUF_SIZE];
+   setp(buf, buf + OUTBUF_SIZE);
+}
+
+OutBuf::OutBuf(const char *filename) : owns_fd(true)
+{
+   fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   buf = new char[OUTBUF_SIZE];
+   setp(buf, buf + OUTBUF_SIZE);
+}
+
+OutBuf::~OutBuf()
+{
+   write_out();
+   if (owns_fd && fd >= 0) close(fd);
+   delete [] buf;
+}
+
+//
+// Hand everything between pbase() and pptr() to the kernel and reset
+// the put area.  Returns false if the descriptor refuses the data.
+//
+bool OutBuf::write_out()
+{
+   char *p = pbase();
+   char *end = pptr();
+
+   while (p < end) {
+      ssize_t n = write(fd, p, end - p);
+      if (n < 0) {
+         if (errno == EINTR) continue;
+         return false;
+      }
+      p += n;
+   }
+   setp(buf, buf + OUTBUF_SIZE);
+   return true;
+}
+
+int OutBuf::overflow(int c)
+{
+   if (fd < 0 || !write_out()) return traits_type::eof();
+   if (c != traits_type::eof()) {
+      *pptr() = (char) c;
+      pbump(1);
+   }
+   return traits_type::not_eof(c);
+}
+
+std::streamsize OutBuf::xsputn(const char *s, std::streamsize n)
+{
+   std::streamsize room = epptr() - pptr();
+
+   if (n <= room) {
+      memcpy(pptr(), s, n);
+      pbump(n);
+      return n;
+   }
+
+   if (fd < 0 || !write_out()) return 0;
+
+   // Anything larger than the whole buffer goes straight through.
+   if (n >= OUTBUF_SIZE) {
+      std::streamsize done = 0;
+      while (done < n) {
+         ssize_t w = write(fd, s + done, n - done);
+         if (w < 0) {
+            if (errno == EINTR) continue;
+            return done;
+         }
+         done += w;
+      }
+      return n;
+   }
+
+   memcpy(pptr(), s, n);
+   pbump(n);
+   return n;
+}
+
+int OutBuf::sync()
+{
+   return (fd >= 0 && write_out()) ? 0 : -1;
+}
+
+ostream& operator<<(ostream& s, fast_int i)
+{
+   char digits[12];
+   char *p = digits + sizeof(digits);
+   unsigned int u = (i.val < 0) ? 0u - (unsigned int) i.val : (unsigned int) i.val;
+
+   do {
+      *--p = '0' + (u % 10);
+      u /= 10;
+   } while (u != 0);
+   if (i.val < 0) *--p = '-';
+
+   s.rdbuf()->sputn(p, digits + sizeof(digits) - p);
+   return s;
+}
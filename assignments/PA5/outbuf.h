@@ -0,0 +1,56 @@
+#ifndef OUTBUF_H_
+#define OUTBUF_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  outbuf.h
+//
+//  OutBuf is a streambuf that collects output in one large user-space
+//  buffer and hands it to the kernel with write(2) only when the buffer
+//  fills up or the stream is destroyed.  Wrap it in an ostream and pass
+//  that wherever an ostream& is expected today:
+//
+//      OutBuf buf(out_filename);
+//      ostream s(&buf);
+//      ast_root->cgen(s);
+//
+//  sync() (and therefore endl/flush) is honoured, so callers on hot
+//  paths should end lines with "\n" rather than endl.
+//
+//  fast_int writes a decimal integer straight into the stream buffer,
+//  bypassing the sentry and locale machinery of operator<<(int):
+//
+//      s << LW << dest_reg << " " << fast_int(offset) << ...
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <streambuf>
+#include "cool-io.h"
+
+#define OUTBUF_SIZE (1 << 16)
+
+class OutBuf : public std::streambuf {
+private:
+   int fd;
+   bool owns_fd;
+   char *buf;
+   bool write_out();
+protected:
+   int overflow(int c);
+   std::streamsize xsputn(const char *s, std::streamsize n);
+   int sync();
+public:
+   OutBuf(int fd);
+   OutBuf(const char *filename);
+   ~OutBuf();
+   bool is_open() { return fd >= 0; }
+};
+
+struct fast_int {
+   int val;
+   explicit fast_int(int v) : val(v) { }
+};
+
+ostream& operator<<(ostream& s, fast_int i);
+
+#endif
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  peephole-test.cc
+//
+//  peephole-test [-n] < function.s
+//
+//  Reads one function's MIPS, as cgen prints it, into a MipsCode, runs
+//  the peephole pass over it (not with -n) and prints the result, so
+//  that script/auto_test.py can hold each rule of peephole.cc to an
+//  expected listing.  Label definitions are lines "name:"; anything
+//  else is a tab, the opcode and its operands, as MipsInsn::print
+//  writes them.  Addresses are labeln or a name taken as it is.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include "mips.h"
+#include "outbuf.h"
+#include "peephole.h"
+
+FILE *ast_file = stdin;       // not used, but needed to link with cgen
+int cool_yydebug;
+char *curr_filename;
+
+static int line_number;
+
+static void bad_line(const std::string& line)
+{
+   cerr << "peephole-test: line " << line_number << ": cannot read \"" << line << "\"" << endl;
+   exit(1);
+}
+
+static MipsAddr address(const std::string& a)
+{
+   if (a.compare(0, 5, "label") == 0 && a.size() > 5
+       && strspn(a.c_str() + 5, "0123456789") == a.size() - 5)
+      return MipsAddr::label(atoi(a.c_str() + 5));
+   return MipsAddr::named(strdup(a.c_str()));
+}
+
+static MipsInsn parse(const std::string& line)
+{
+   if (line[line.size() - 1] == ':')
+      return MipsInsn(MIPS_LABEL, -1, -1, -1, 0, address(line.substr(0, line.size() - 1)));
+
+   // "4($fp)" reads as "4 $fp"
+   std::string text(line);
+   for (size_t i = 0; i < text.size(); i++)
+      if (text[i] == '(' || text[i] == ')') text[i] = ' ';
+   std::istringstream in(text);
+   std::string name;
+   std::vector<std::string> arg;
+   in >> name;
+   for (std::string w; in >> w; ) arg.push_back(w);
+
+   int op = 0;
+   while (op < MIPS_OP_COUNT && (op == MIPS_LABEL || name != mips_op_names[op])) op++;
+   if (op == MIPS_OP_COUNT) bad_line(line);
+
+   size_t want;
+   switch (op) {
+   case MIPS_JALR: case MIPS_JR: case MIPS_JAL: case MIPS_B: want = 1; break;
+   case MIPS_LI: case MIPS_LA: case MIPS_MOVE: case MIPS_NEG: case MIPS_BEQZ: want = 2; break;
+   default: want = 3; break;
+   }
+   if (arg.size() != want) bad_line(line);
+
+   MipsOp o = (MipsOp) op;
+   switch (o) {
+   case MIPS_LW: case MIPS_SW:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), mips_reg(arg[2].c_str()), -1, atoi(arg[1].c_str()));
+   case MIPS_LI:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), -1, -1, atoi(arg[1].c_str()));
+   case MIPS_LA:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), -1, -1, 0, address(arg[1]));
+   case MIPS_MOVE: case MIPS_NEG:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), mips_reg(arg[1].c_str()));
+   case MIPS_ADDIU: case MIPS_SLL: case MIPS_XORI:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), mips_reg(arg[1].c_str()), -1, atoi(arg[2].c_str()));
+   case MIPS_JALR: case MIPS_JR:
+      return MipsInsn(o, -1, mips_reg(arg[0].c_str()));
+   case MIPS_JAL: case MIPS_B:
+      return MipsInsn(o, -1, -1, -1, 0, address(arg[0]));
+   case MIPS_BEQZ:
+      return MipsInsn(o, -1, mips_reg(arg[0].c_str()), -1, 0, address(arg[1]));
+   case MIPS_BEQ: case MIPS_BNE: case MIPS_BLE: case MIPS_BLT: case MIPS_BGT:
+      if (arg[1][0] == '$')
+         return MipsInsn(o, -1, mips_reg(arg[0].c_str()), mips_reg(arg[1].c_str()), 0, address(arg[2]));
+      return MipsInsn(o, -1, mips_reg(arg[0].c_str()), -1, atoi(arg[1].c_str()), address(arg[2]));
+   default:
+      return MipsInsn(o, mips_reg(arg[0].c_str()), mips_reg(arg[1].c_str()), mips_reg(arg[2].c_str()));
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   bool rewrite = !(argc > 1 && strcmp(argv[1], "-n") == 0);
+   MipsCode code;
+   char buf[1024];
+   while (fgets(buf, sizeof buf, stdin) != NULL) {
+      line_number++;
+      std::string line(buf);
+      while (!line.empty() && strchr(" \t\r\n", line[line.size() - 1])) line.erase(line.size() - 1);
+      size_t start = line.find_first_not_of(" \t");
+      if (start == std::string::npos || line[start] == '#') continue;
+      code.add(parse(line));
+   }
+   if (rewrite) peephole(code);
+
+   OutBuf out(1);
+   ostream s(&out);
+   code.print(s);
+   return 0;
+}
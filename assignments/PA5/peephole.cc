@@ -0,0 +1,185 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  peephole.cc
+//
+//  The peephole pass over one function's MIPS; see peephole.h.  The
+//  rules, applied until none does anything:
+//
+//    move r r                        goes
+//    move a b; move b a              the second goes
+//    sw r x; lw r x                  the load goes
+//    sw r x; lw q x                  the load becomes move q r
+//    lw r x; lw r x                  the second goes, if x is not r-based
+//    addiu $sp $sp a; <loads and stores off $sp>; addiu $sp $sp b
+//                                    one addiu of a + b after the loads
+//                                    and stores, whose offsets take a
+//    b L, where L: b M               b M; likewise conditional branches
+//    b L; L:                         the branch goes; likewise
+//                                    conditional branches
+//    code after b or jr up to the next label goes, and so do labels
+//    no branch refers to
+//
+//  Each rule looks at adjacent instructions only, so nothing else can
+//  observe the difference: pushes are stores below $sp, which no
+//  interrupt or collector sees before the addiu that covers them.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <set>
+#include "peephole.h"
+
+static bool is_sp_adjust(const MipsInsn& in)
+{
+   return in.op == MIPS_ADDIU && in.d == MIPS_SP && in.s == MIPS_SP;
+}
+
+static bool is_memory(const MipsInsn& in)
+{
+   return in.op == MIPS_LW || in.op == MIPS_SW;
+}
+
+static bool same_address(const MipsInsn& x, const MipsInsn& y)
+{
+   return x.s == y.s && x.imm == y.imm;
+}
+
+class Peephole {
+private:
+   std::vector<MipsInsn>& insns;
+   std::vector<bool> gone;
+
+   int next(int i);
+   int target(int label);
+   bool rule(int i);
+public:
+   Peephole(MipsCode& code) : insns(code.insns), gone(insns.size(), false) { }
+   void run();
+   void compact();
+};
+
+//
+// The instruction after i still there, or insns.size().
+//
+int Peephole::next(int i)
+{
+   for (i++; i < (int) insns.size() && gone[i]; i++) ;
+   return i;
+}
+
+//
+// The first instruction at or after the definition of `label'.
+//
+int Peephole::target(int label)
+{
+   for (int i = 0; i < (int) insns.size(); i++)
+      if (!gone[i] && insns[i].op == MIPS_LABEL && insns[i].addr.is_label(label)) {
+         while (i < (int) insns.size() && (gone[i] || insns[i].op == MIPS_LABEL)) i++;
+         return i;
+      }
+   return insns.size();
+}
+
+bool Peephole::rule(int i)
+{
+   MipsInsn& in = insns[i];
+   int j = next(i);
+   MipsInsn *n = j < (int) insns.size() ? &insns[j] : NULL;
+
+   if (in.op == MIPS_MOVE && in.d == in.s) {
+      gone[i] = true;
+      return true;
+   }
+   if (n == NULL) return false;
+
+   if (in.op == MIPS_MOVE && n->op == MIPS_MOVE && in.d == n->s && in.s == n->d) {
+      gone[j] = true;
+      return true;
+   }
+
+   if (in.op == MIPS_SW && n->op == MIPS_LW && same_address(in, *n)) {
+      if (n->d == in.d)
+         gone[j] = true;
+      else
+         *n = MipsInsn(MIPS_MOVE, n->d, in.d);
+      return true;
+   }
+   if (in.op == MIPS_LW && n->op == MIPS_LW && in.d == n->d && same_address(in, *n)
+       && in.s != in.d) {
+      gone[j] = true;
+      return true;
+   }
+
+   if (is_sp_adjust(in)) {
+      int k = j;
+      std::vector<int> between;
+      for (; k < (int) insns.size(); k = next(k))
+         if (is_memory(insns[k]) && insns[k].s == MIPS_SP && insns[k].d != MIPS_SP)
+            between.push_back(k);
+         else
+            break;
+      if (k < (int) insns.size() && is_sp_adjust(insns[k])) {
+         for (size_t b = 0; b < between.size(); b++) insns[between[b]].imm += in.imm;
+         insns[k].imm += in.imm;
+         gone[i] = true;
+         if (insns[k].imm == 0) gone[k] = true;
+         return true;
+      }
+   }
+
+   if (in.is_branch()) {
+      int t = target(in.addr.n);
+      if (t < (int) insns.size() && insns[t].op == MIPS_B && !insns[t].addr.is_label(in.addr.n)) {
+         in.addr = insns[t].addr;
+         return true;
+      }
+      for (int k = j; k < (int) insns.size() && insns[k].op == MIPS_LABEL; k = next(k))
+         if (insns[k].addr.is_label(in.addr.n)) {
+            gone[i] = true;
+            return true;
+         }
+   }
+
+   if ((in.op == MIPS_B || in.op == MIPS_JR) && n->op != MIPS_LABEL) {
+      gone[j] = true;
+      return true;
+   }
+   return false;
+}
+
+void Peephole::run()
+{
+   // The bound only matters for branches that chase each other round a
+   // cycle of labels.
+   for (int pass = 0, changed = 1; changed && pass < 100; pass++) {
+      changed = 0;
+      for (int i = 0; i < (int) insns.size(); i++)
+         if (!gone[i] && insns[i].op != MIPS_LABEL && rule(i)) changed = 1;
+
+      std::set<int> used;
+      for (size_t i = 0; i < insns.size(); i++)
+         if (!gone[i] && insns[i].op != MIPS_LABEL && insns[i].addr.kind == ADDR_LABEL)
+            used.insert(insns[i].addr.n);
+      for (size_t i = 0; i < insns.size(); i++)
+         if (!gone[i] && insns[i].is_local_label() && !used.count(insns[i].addr.n)) {
+            gone[i] = true;
+            changed = 1;
+         }
+   }
+}
+
+void Peephole::compact()
+{
+   size_t k = 0;
+   for (size_t i = 0; i < insns.size(); i++)
+      if (!gone[i]) insns[k++] = insns[i];
+   insns.erase(insns.begin() + k, insns.end());
+}
+
+int peephole(MipsCode& code)
+{
+   int before = code.size();
+   Peephole p(code);
+   p.run();
+   p.compact();
+   return before - code.size();
+}
@@ -0,0 +1,20 @@
+#ifndef PEEPHOLE_H_
+#define PEEPHOLE_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  peephole.h
+//
+//  With -O, the MIPS FunctionCoder writes for a function is improved
+//  through a small window before it is printed; see peephole.cc for
+//  the rules.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "mips.h"
+
+// Rewrites `code', one function, and returns how many instructions
+// fewer it has.
+int peephole(MipsCode& code);
+
+#endif
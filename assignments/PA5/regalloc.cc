@@ -0,0 +1,228 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  regalloc.cc
+//
+//  Linear-scan register allocation for IrFunctions; see regalloc.h.
+//
+//  Instructions are numbered in the order they are written out.  Each
+//  has two positions: 2i, where it reads its operands, and 2i + 1, where
+//  it writes its result, so one register can hold an operand's last use
+//  and the result of the same instruction.  A register's interval runs
+//  from its first to its last position, including the edges of the
+//  blocks it is live into or out of (the position before the first
+//  instruction and after the last).  Intervals have no holes, which
+//  costs nothing for the short-lived temporaries that are most of them.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <limits.h>
+#include "regalloc.h"
+#include "cgen_gc.h"
+
+extern Memmgr cgen_Memmgr;
+
+// $t1, $t2, $a0 and $a1 are the scratch registers of the emitted code.
+static const int temp_regs[] = { 8, 11, 12, 13, 14, 15, 24, 25 };
+
+// $s0 holds self and $s7 belongs to the collector.
+static const int saved_regs[] = { 17, 18, 19, 20, 21, 22 };
+
+#define NELEMS(a) ((int) (sizeof(a) / sizeof(a[0])))
+
+bool calls_out(const IrInsn& in)
+{
+   switch (in.op) {
+   case IR_NEW: case IR_STACKNEW: case IR_NEWSELF: case IR_INIT: case IR_CALL:
+   case IR_SCALL: case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_NEG:
+   case IR_EQUAL: case IR_BOX:
+      return true;
+   case IR_SETATTR:
+      return cgen_Memmgr == GC_GENGC;
+   default:
+      return false;
+   }
+}
+
+//
+// Arithmetic allocates its result before it reads its operands, so
+// they must survive the allocation.
+//
+static bool reads_after_call(const IrInsn& in)
+{
+   return in.op == IR_ADD || in.op == IR_SUB || in.op == IR_MUL || in.op == IR_DIV
+      || in.op == IR_NEG;
+}
+
+void allocate_frame(IrFunction& f, Allocation& a)
+{
+   a.reg.assign(f.nregs, REG_FRAME);
+   a.saved.clear();
+   for (size_t b = 0; b < f.blocks.size(); b++)
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         if (in.op == IR_PARAM && in.imm == 0) a.reg[in.dst] = REG_SELF;
+      }
+}
+
+class LinearScan {
+private:
+   IrFunction& f;
+   Allocation& a;
+   std::vector<int> start, end, hint;
+   std::vector<bool> crosses;
+   std::vector<bool> number;                   // never in a callee-saved register
+   std::vector<int> active;                    // registers holding a value
+   bool in_use[32];
+
+   void extend(int r, int pos)
+   {
+      start[r] = std::min(start[r], pos);
+      end[r] = std::max(end[r], pos);
+   }
+   bool take(int r, int m)
+   {
+      if (in_use[m]) return false;
+      in_use[m] = true;
+      a.reg[r] = m;
+      active.push_back(r);
+      return true;
+   }
+   void intervals();
+   bool choose(int r, const int *pool, int n);
+   void spill(int r);
+public:
+   LinearScan(IrFunction& fn, Allocation& al) : f(fn), a(al) { }
+   void run();
+};
+
+void LinearScan::intervals()
+{
+   int n = f.nregs;
+   start.assign(n, INT_MAX);
+   end.assign(n, -1);
+   hint.assign(n, -1);
+   crosses.assign(n, false);
+
+   std::vector<std::vector<bool> > live_in, live_out;
+   f.liveness(live_in, live_out);
+   f.numbers(number);
+
+   std::vector<int> calls, uses;
+   int pos = 0;
+   for (size_t b = 0; b < f.blocks.size(); b++) {
+      for (int r = 0; r < n; r++)
+         if (live_in[b][r]) extend(r, 2 * pos - 1);
+      for (size_t i = 0; i < f.blocks[b].insns.size(); i++, pos++) {
+         IrInsn& in = f.blocks[b].insns[i];
+         in.uses(uses);
+         for (size_t k = 0; k < uses.size(); k++) {
+            extend(uses[k], 2 * pos);
+            if (reads_after_call(in)) crosses[uses[k]] = true;
+         }
+         if (in.dst >= 0) extend(in.dst, 2 * pos + 1);
+         if (in.op == IR_MOVE) {
+            hint[in.dst] = in.a;
+            hint[in.a] = in.dst;
+         }
+         if (calls_out(in)) calls.push_back(pos);
+      }
+      for (int r = 0; r < n; r++)
+         if (live_out[b][r]) extend(r, 2 * pos - 1);
+   }
+
+   // A value survives the call at i if it is there before 2i and still
+   // needed after 2i + 1.
+   for (int r = 0; r < n; r++) {
+      if (end[r] < 0) continue;
+      std::vector<int>::iterator c = std::upper_bound(calls.begin(), calls.end(), start[r] / 2);
+      if (c != calls.end() && 2 * *c + 1 < end[r]) crosses[r] = true;
+   }
+
+   // optimize.cc never leaves a number live across a call, so a call
+   // inside a number's interval falls in a hole in it.
+   for (int r = 0; r < n; r++)
+      if (number[r]) crosses[r] = false;
+}
+
+//
+// The hinted register if it is free, else the first free one.
+//
+bool LinearScan::choose(int r, const int *pool, int n)
+{
+   int h = hint[r] >= 0 ? a.reg[hint[r]] : -1;
+   for (int i = 0; i < n; i++)
+      if (pool[i] == h && take(r, h)) return true;
+   for (int i = 0; i < n; i++)
+      if (take(r, pool[i])) return true;
+   return false;
+}
+
+//
+// With no register free, whichever of `r' and the values in registers
+// it could use lives longest goes to the frame.
+//
+void LinearScan::spill(int r)
+{
+   int victim = -1;
+   for (size_t i = 0; i < active.size(); i++) {
+      int w = active[i];
+      bool saved = a.reg[w] >= 17 && a.reg[w] <= 22;
+      if (a.reg[w] == REG_SELF || (crosses[r] && !saved) || (number[r] && saved)) continue;
+      if (victim < 0 || end[w] > end[victim]) victim = w;
+   }
+   if (victim < 0 || end[victim] <= end[r]) {
+      a.reg[r] = REG_FRAME;
+      return;
+   }
+   a.reg[r] = a.reg[victim];
+   a.reg[victim] = REG_FRAME;
+   std::replace(active.begin(), active.end(), victim, r);
+}
+
+void LinearScan::run()
+{
+   intervals();
+   a.reg.assign(f.nregs, REG_UNUSED);
+   a.saved.clear();
+   for (int m = 0; m < 32; m++) in_use[m] = false;
+
+   std::vector<std::pair<int, int> > order;
+   for (int r = 0; r < f.nregs; r++)
+      if (end[r] > start[r]) order.push_back(std::make_pair(start[r], r));
+   std::sort(order.begin(), order.end());
+
+   for (size_t i = 0; i < order.size(); i++) {
+      int r = order[i].second;
+      for (size_t k = 0; k < active.size(); )
+         if (end[active[k]] < start[r]) {
+            in_use[a.reg[active[k]]] = false;
+            active[k] = active.back();
+            active.pop_back();
+         } else
+            k++;
+
+      IrInsn& first = f.blocks[0].insns[0];
+      if (first.op == IR_PARAM && first.dst == r) {
+         take(r, REG_SELF);
+         continue;
+      }
+      if (crosses[r] ? choose(r, saved_regs, NELEMS(saved_regs))
+                     : choose(r, temp_regs, NELEMS(temp_regs))
+                       || (!number[r] && choose(r, saved_regs, NELEMS(saved_regs))))
+         continue;
+      spill(r);
+   }
+
+   for (int k = 0; k < NELEMS(saved_regs); k++)
+      for (int r = 0; r < f.nregs; r++)
+         if (a.reg[r] == saved_regs[k]) {
+            a.saved.push_back(saved_regs[k]);
+            break;
+         }
+}
+
+void allocate_registers(IrFunction& f, Allocation& a)
+{
+   LinearScan(f, a).run();
+}
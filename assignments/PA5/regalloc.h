@@ -0,0 +1,43 @@
+#ifndef REGALLOC_H_
+#define REGALLOC_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  regalloc.h
+//
+//  Where each register of an IrFunction lives when it is written out
+//  as MIPS: in a machine register, in a word of the frame, or nowhere
+//  if nothing reads it.
+//
+//  allocate_registers is a linear scan over one live interval per
+//  register.  Values that must survive a call, or anything else that
+//  can run the collector, go in $s1-$s6: the callee saves those, and
+//  the collector updates them when it moves objects.  Other values can
+//  also use the caller-saved registers the emitted code does not use as
+//  scratch, and numbers (IrFunction::numbers), which are never live
+//  across a call, use only those or the frame.  allocate_frame puts
+//  everything in the frame, for -r.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "ir.h"
+#include "mips.h"
+
+#define REG_FRAME   -1            // in a word of the frame
+#define REG_UNUSED  -2            // never read
+
+#define REG_SELF    16            // $s0, self in every method
+
+struct Allocation {
+   std::vector<int> reg;          // by register: MIPS number or REG_*
+   std::vector<int> saved;        // callee-saved registers it uses
+};
+
+// Whether the code for `in' calls a method or the runtime.  That
+// clobbers the caller-saved registers and may move objects.
+bool calls_out(const IrInsn& in);
+
+void allocate_registers(IrFunction& f, Allocation& a);
+void allocate_frame(IrFunction& f, Allocation& a);
+
+#endif
@@ -161,10 +161,12 @@ public:
 template <class Elem> class append_node : public list_node<Elem> {
 private:
     list_node<Elem> *some, *rest;
+    int length;                 // lists are immutable; cache the length
 public:
     append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
 	some = l1;
 	rest = l2;
+	length = l1->len() + l2->len();
     }
     list_node<Elem> *copy_list();
     int len();
@@ -353,7 +355,7 @@ template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> int append_node<Elem>::len()
 {
-    return some->len() + rest->len();
+    return length;
 }
 
 
@@ -366,14 +368,15 @@ template <class Elem> int append_node<Elem>::len()
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> Elem append_node<Elem>::nth_length(int n, int &len)
 {
-    int rlen;
-    Elem tmp = some->nth_length(n, len);
+    int slen = some->len();
+    int sublen;
 
-    if (!tmp) {
-	tmp = rest->nth_length(n-len, rlen);
-	len += rlen;
-    }
-    return tmp;
+    len = length;
+    if (n < 0 || n >= length)
+	return NULL;
+    if (n < slen)
+	return some->nth_length(n, sublen);
+    return rest->nth_length(n - slen, sublen);
 }
 
 
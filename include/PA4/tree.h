@@ -17,6 +17,7 @@
 
 #include "stringtab.h"
 #include "cool-io.h"
+#include <atomic>
 
 /////////////////////////////////////////////////////////////////////
 //
@@ -127,6 +128,7 @@ public:
     virtual ~list_node() { }
     virtual int len() = 0;
     virtual Elem nth_length(int n, int &len) = 0;
+    virtual void flatten(Elem *out) = 0;  // store the elements in out[0..len)
 
     static list_node<Elem> *nil();
     static list_node<Elem> *single(Elem);
@@ -142,6 +144,7 @@ public:
     list_node<Elem> *copy_list();
     int len();
     Elem nth_length(int n, int &len);
+    void flatten(Elem *) { }
     void dump(ostream& stream, int n);
 };
 
@@ -154,6 +157,7 @@ public:
     list_node<Elem> *copy_list();
     int len();
     Elem nth_length(int n, int &len);
+    void flatten(Elem *out) { out[0] = elem; }
     void dump(ostream& stream, int n);
 };
 
@@ -161,15 +165,19 @@ public:
 template <class Elem> class append_node : public list_node<Elem> {
 private:
     list_node<Elem> *some, *rest;
+    int length;                 // lists are immutable; cache the length
+    std::atomic<Elem *> flat;   // ... and, once indexed, the elements
 public:
-    append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
+    append_node(list_node<Elem> *l1, list_node<Elem> *l2) : flat(NULL) {
 	some = l1;
 	rest = l2;
+	length = l1->len() + l2->len();
     }
     list_node<Elem> *copy_list();
     int len();
     Elem nth(int n);
     Elem nth_length(int n, int &len);
+    void flatten(Elem *out);
     void dump(ostream& stream, int n);
 };
 
@@ -353,7 +361,7 @@ template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> int append_node<Elem>::len()
 {
-    return some->len() + rest->len();
+    return length;
 }
 
 
@@ -363,17 +371,67 @@ template <class Elem> int append_node<Elem>::len()
 //
 // return the nth element on the list
 //
+// Lists built by appending one element at a time are as deep as they
+// are long, so the first lookup in a long list copies its elements into
+// an array and every later one is a single index.
+//
+// Flattening when the node is built would copy a list once per element
+// appended to it, so it stays lazy.  semant -j looks lists up from
+// several threads; two threads indexing the same list may both build
+// the array, and the one that publishes second drops its own copy.
+//
 ///////////////////////////////////////////////////////////////////////////
+#define FLATTEN_MIN_LENGTH 8
+
 template <class Elem> Elem append_node<Elem>::nth_length(int n, int &len)
 {
-    int rlen;
-    Elem tmp = some->nth_length(n, len);
+    int slen = some->len();
+    int sublen;
 
-    if (!tmp) {
-	tmp = rest->nth_length(n-len, rlen);
-	len += rlen;
+    len = length;
+    if (n < 0 || n >= length)
+	return NULL;
+    Elem *elems = flat.load(std::memory_order_acquire);
+    if (elems == NULL && length >= FLATTEN_MIN_LENGTH) {
+	Elem *mine = new Elem[length];
+	flatten(mine);
+	if (flat.compare_exchange_strong(elems, mine, std::memory_order_acq_rel))
+	    elems = mine;
+	else
+	    delete [] mine;
     }
-    return tmp;
+    if (elems)
+	return elems[n];
+    if (n < slen)
+	return some->nth_length(n, sublen);
+    return rest->nth_length(n - slen, sublen);
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// append_node::flatten
+//
+// store the elements of the list in out[0..len()).  The left spine is
+// walked iteratively so deep left-leaning lists do not recurse.
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> void append_node<Elem>::flatten(Elem *out)
+{
+    list_node<Elem> *l = this;
+    append_node<Elem> *a;
+    Elem *elems = NULL;
+
+    while ((a = dynamic_cast<append_node<Elem> *>(l)) != NULL
+	   && (elems = a->flat.load(std::memory_order_acquire)) == NULL) {
+	a->rest->flatten(out + a->some->len());
+	l = a->some;
+    }
+    if (a)
+	for (int i = 0; i < a->length; i++)
+	    out[i] = elems[i];
+    else
+	l->flatten(out);
 }
 
 
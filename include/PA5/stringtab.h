@@ -11,6 +11,9 @@
 
 #include <assert.h>
 #include <string.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
 #include "list.h"    // list template
 #include "cool-io.h"
 
@@ -95,6 +98,8 @@ class StringTable
 protected:
    List<Elem> *tbl;   // a string table is a list
    int index;         // the current index
+   std::unordered_map<std::string, Elem *> by_string;  // index on tbl
+   std::vector<Elem *> by_index;                       // index on tbl
 public:
    StringTable(): tbl((List<Elem> *) NULL), index(0) { }   // an empty table
    // The following methods each add a string to the string table.  
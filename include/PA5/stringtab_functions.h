@@ -13,7 +13,8 @@
 
 //
 // A string table is implemented a linked list of Entrys.  Each Entry
-// in the list has a unique string.
+// in the list has a unique string.  The list is indexed by string and
+// by entry index, so neither adding nor looking up walks it.
 //
 
 template <class Elem>
@@ -23,7 +24,7 @@ Elem *StringTable<Elem>::add_string(char *s)
 }
 
 //
-// Add a string requires two steps.  First, the list is searched; if the
+// Add a string requires two steps.  First, the table is searched; if the
 // string is found, a pointer to the existing Entry for that string is 
 // returned.  If the string is not found, a new Entry is created and added
 // to the list.
@@ -32,29 +33,29 @@ template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s, int maxchars)
 {
   int len = min((int) strlen(s),maxchars);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
+  std::string key(s, len);
+  typename std::unordered_map<std::string, Elem *>::iterator it = by_string.find(key);
+  if (it != by_string.end())
+    return it->second;
 
   Elem *e = new Elem(s,len,index++);
   tbl = new List<Elem>(e, tbl);
+  by_string[key] = e;
+  by_index.push_back(e);
   return e;
 }
 
 //
-// To look up a string, the list is scanned until a matching Entry is located.
+// To look up a string, the table is searched for a matching Entry.
 // If no such entry is found, an assertion failure occurs.  Thus, this function
 // is used only for strings that one expects to find in the table.
 //
 template <class Elem>
 Elem *StringTable<Elem>::lookup_string(char *s)
 {
-  int len = strlen(s);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  typename std::unordered_map<std::string, Elem *>::iterator it = by_string.find(s);
+  assert(it != by_string.end());   // fail if string is not found
+  return it->second;
 }
 
 //
@@ -64,11 +65,8 @@ Elem *StringTable<Elem>::lookup_string(char *s)
 template <class Elem>
 Elem *StringTable<Elem>::lookup(int ind)
 {
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_index(ind))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(ind >= 0 && ind < (int) by_index.size());   // fail if index is not found
+  return by_index[ind];
 }
 
 //
@@ -8,12 +8,13 @@ import logging
 
 ROOT = os.getcwd() + "/.."
 CASE_DIR = ROOT + "/examples"
-CASEFILE = "case.list"
+PEEPHOLE_DIR = os.getcwd() + "/peephole"
+CASEFILE = {"PA3": "case.list", "PA4": "case.list", "PA5": "peephole.list"}
 MYDIR = ""
-case_list = open(CASEFILE).readlines()
+case_list = []
 golden_result = {}
 my_result = {}
-PA_mapping = {"PA2": "lexer", "PA3": "parser", "PA4": "semant"}
+PA_mapping = {"PA2": "lexer", "PA3": "parser", "PA4": "semant", "PA5": "peephole-test"}
 
 def run_cmd(cmd, timeout=None):
     try:
@@ -88,43 +89,67 @@ def mycmd(cmd):
     else :
         return result[1]
 
+# PA5 cases are listings the peephole pass rewrites, each with the
+# listing it should come out as.
+def case_file(case, pa):
+    if (pa == "PA5"):
+        return PEEPHOLE_DIR + '/' + case + ".s"
+    return CASE_DIR + '/' + case + ".cl"
+
+# PA3 holds parser -i to a plain parse, for cool.y and for -d: the
+# second of two runs over the same cache, when every class comes from
+# it, must print the same AST.
+PARSERS = ["", "-d"]
+
+def parse_cmd(case, flags):
+    return "; ".join(["./lexer {} | ./parser {} {}".format(case_file(case, "PA3"), flags, p)
+                      for p in PARSERS])
+
 def get_my(case, pa):
+    if (pa == "PA3"):
+        mycmd("cd {} && rm -rf .coolcache".format(MYDIR))
+        mycmd("cd {} && ({}) > /dev/null".format(MYDIR, parse_cmd(case, "-i")))
+        my_result[case] = mycmd("cd {} && ({}) > myresult".format(MYDIR, parse_cmd(case, "-i")))
     if (pa == "PA4"):
-        my_result[case] = mycmd("cd {} && ./lexer {} | ./parser $* | ./semant $* > myresult".format(MYDIR, CASE_DIR + '/' + case + ".cl")) 
+        my_result[case] = mycmd("cd {} && ./lexer {} | ./parser $* | ./semant $* > myresult".format(MYDIR, case_file(case, pa))) 
+    if (pa == "PA5"):
+        my_result[case] = mycmd("cd {} && ./peephole-test < {} > myresult".format(MYDIR, case_file(case, pa)))
 
 def get_golden(case, pa):
+    if (pa == "PA3"):
+        golden_result[case] = mycmd("cd {} && ({}) > goldenresult".format(MYDIR, parse_cmd(case, "")))
     if (pa == "PA4"):
-        golden_result[case] = mycmd("cd {} && ./lexer {} | ./parser $* | semant $* > goldenresult".format(MYDIR, CASE_DIR + '/' + case + ".cl")) 
+        golden_result[case] = mycmd("cd {} && ./lexer {} | ./parser $* | semant $* > goldenresult".format(MYDIR, case_file(case, pa))) 
+    if (pa == "PA5"):
+        golden_result[case] = mycmd("cd {} && cp {} goldenresult && cat goldenresult".format(MYDIR, PEEPHOLE_DIR + '/' + case + ".out"))
 
 def get_cmp(case, pa):
-    if (pa == "PA4"):
+    if (pa in CASEFILE):
         mycmd("cd {} && rm myresult goldenresult".format(MYDIR))
         get_golden(case, pa)
         get_my(case, pa)
         res = mycmd("cd {} && diff myresult goldenresult".format(MYDIR))
-        if len(res) == 0:
+        if res is not None and len(res) == 0:
             return True
         else:
             return False
     return False
 
 def clean_s():
-    mycmd("cd {} && make clean".format(MYDIR))
-    for case in case_list:
-        mycmd("rm {}".format(CASE_DIR + '/' + case + ".s"))
+    mycmd("cd {} && make clean && rm -f myresult goldenresult".format(MYDIR))
 
-def init():
+def init(pa):
+    case_list.extend(open(CASEFILE.get(pa, "case.list")).readlines())
     for i in range(case_list.__len__()):
         case_list[i] = case_list[i].strip()
 
 if __name__ == "__main__":
-    init()
-    
     if (len(sys.argv) < 3):
         print("format is python auto_test.py [clean|run] $PAx")
         exit(1)
     cmd = sys.argv[1]
     pa = sys.argv[2]
+    init(pa)
     MYDIR = ROOT + "/assignments/" + pa
     clean_s()
     faillog = open("faillog.txt", "+w")
@@ -132,7 +157,7 @@ if __name__ == "__main__":
     mycmd("cd {} && make clean && make -j && make {} -j".format(MYDIR, PA_mapping[pa]))
     if (cmd == "run"):
         for case in case_list:
-            if (not os.path.isfile(CASE_DIR + '/' + case + ".cl")):
+            if (not os.path.isfile(case_file(case, pa))):
                 continue
             if (get_cmp(case, pa) == False):
                 faillog.write("===== case {} result for golden is ===== \n{}".format(case, golden_result[case]))
@@ -0,0 +1,9 @@
+# b L; L: the branch goes; likewise a conditional branch
+	bne	$a0 $zero label4
+	jal	_dispatch_abort
+label4:
+	b	label5
+label5:
+	beq	$t1 0 label6
+label6:
+	jr	$ra	
@@ -0,0 +1,13 @@
+# b L, where L: b M becomes b M; likewise a conditional branch
+	beqz	$t1 label1
+	li	$a0 1
+	b	label1
+label2:
+	li	$a0 3
+	jr	$ra	
+label1:
+	b	label3
+label3:
+	li	$a0 2
+	blt	$t1 $t2 label2
+	jr	$ra	
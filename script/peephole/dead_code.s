@@ -0,0 +1,11 @@
+# code after b or jr up to the next label goes
+	bgt	$t1 $t2 label7
+	b	label8
+	li	$a0 1
+	move	$a1 $a0
+label7:
+	li	$a0 2
+label8:
+	jr	$ra	
+	li	$a0 3
+	sw	$a0 0($sp)
@@ -0,0 +1,8 @@
+# lw r x; lw r x: the second goes
+	lw	$t1 12($fp)
+	lw	$t1 12($fp)
+	jal	Object.copy
+# unless x is r-based: the first load changed r
+	lw	$t1 8($t1)
+	lw	$t1 8($t1)
+	jr	$ra	
@@ -0,0 +1,4 @@
+# move a b; move b a: the second goes
+	move	$a0 $s1
+	move	$s1 $a0
+	jr	$ra	
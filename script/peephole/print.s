@@ -0,0 +1,49 @@
+# Every opcode and every kind of address, in an order no rule touches:
+# what comes out must be what went in
+Main.f:
+	addiu	$sp $sp -12
+	sw	$fp 12($sp)
+	sw	$s0 8($sp)
+	sw	$ra 4($sp)
+	addiu	$fp $sp 4
+	move	$s0 $a0
+	la	$a0 Int_protObj
+	jal	Object.copy
+	jal	Int_init
+	la	$t1 int_const3
+	la	$t2 str_const1
+	la	$t3 bool_const0
+	li	$t4 -7
+	neg	$t4 $t4
+	add	$t4 $t4 $t5
+	addu	$t5 $t5 $t4
+	div	$t4 $t4 $t5
+	mul	$t4 $t4 $t5
+	sub	$t4 $t4 $t5
+	slt	$t6 $t4 $t5
+	sle	$t6 $t4 $t5
+	seq	$t6 $t4 $t5
+	xori	$t6 $t6 1
+	sll	$t2 $t2 3
+	lw	$t1 8($a0)
+	jalr		$t1
+	beqz	$a0 label1
+	beq	$t4 $t5 label2
+	beq	$t4 3 label3
+	bne	$t4 $zero label2
+	ble	$t4 $t5 label3
+	blt	$t4 $t5 label1
+	bgt	$t4 $t5 label2
+	b	label3
+label1:
+	li	$a0 1
+	jal	Main.g
+label2:
+	li	$a0 2
+	jal	Main.g
+label3:
+	lw	$fp 12($sp)
+	lw	$s0 8($sp)
+	lw	$ra 4($sp)
+	addiu	$sp $sp 12
+	jr	$ra	
@@ -0,0 +1,4 @@
+# move r r goes
+	lw	$t1 12($fp)
+	move	$t1 $t1
+	jr	$ra	
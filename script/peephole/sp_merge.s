@@ -0,0 +1,13 @@
+# addiu $sp $sp a; loads and stores off $sp; addiu $sp $sp b:
+# one addiu of a + b after them, with their offsets rebased by a
+	sw	$a0 0($sp)
+	addiu	$sp $sp -4
+	sw	$s1 0($sp)
+	lw	$t1 4($sp)
+	addiu	$sp $sp -4
+	jal	Main.f
+# a push popped straight away cancels out
+	addiu	$sp $sp -4
+	lw	$t2 8($sp)
+	addiu	$sp $sp 4
+	jr	$ra	
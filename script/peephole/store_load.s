@@ -0,0 +1,8 @@
+# sw r x; lw r x: the load goes
+	sw	$a0 12($fp)
+	lw	$a0 12($fp)
+	jal	Object.copy
+# but not from another address
+	sw	$a0 12($fp)
+	lw	$a0 16($fp)
+	jr	$ra	
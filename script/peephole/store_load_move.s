@@ -0,0 +1,4 @@
+# sw r x; lw q x: the load becomes move q r
+	sw	$a0 0($sp)
+	lw	$t1 0($sp)
+	jr	$ra	
@@ -0,0 +1,8 @@
+# labels no branch refers to go; names other than labeln stay
+Main.main:
+	ble	$t1 $t2 label9
+label10:
+	li	$a0 1
+label9:
+	la	$a0 Main_protObj
+	jr	$ra	